@@ -1,6 +1,7 @@
 #include "app.h"
 #include "libs/furi_utils.h"
 #include "src/alloc_free.h"
+#include "src/bt.h"
 #include "libs/jsmn.h"
 #include <storage/storage.h>
 
@@ -8,11 +9,77 @@ const uint16_t beacon_period_values[4] = {20, 50, 75, 100};
 const char* beacon_period_names[4] = {"20ms", "50ms", "75ms", "100ms"};
 const uint16_t beacon_duration_values[4] = {1000, 2000, 5000, 10000};
 const char* beacon_duration_names[4] = {"1s", "2s", "5s", "10s"};
-const char* randomize_mac_names[2] = {"Off", "On"};
+const char* adv_schedule_names[2] = {"Fixed", "Adaptive"};
+const uint8_t send_count_values[5] = {0, 3, 5, 10, 20};
+const char* send_count_names[5] = {"Off", "3", "5", "10", "20"};
+const AdvJitter adv_jitter_values[4] = {{0, 0}, {10, 10}, {20, 25}, {50, 50}};
+const char* adv_jitter_names[4] = {"Off", "10ms 10%", "20ms 25%", "50ms 50%"};
+const char* profile_names[PROFILE_COUNT] = {"Near", "Room", "Floor", "Far"};
+const GapAdvPowerLevel tx_power_values[6] = {
+    GapAdvPowerLevel_Neg20_85dBm, // Auto, starting level
+    GapAdvPowerLevel_Neg20_85dBm,
+    GapAdvPowerLevel_Neg12_05dBm,
+    GapAdvPowerLevel_Neg6_9dBm,
+    GapAdvPowerLevel_0dBm,
+    GapAdvPowerLevel_6dBm,
+};
+const char* tx_power_names[6] = {"Auto", "-21dBm", "-12dBm", "-7dBm", "0dBm", "+6dBm"};
+const GapAdvChannelMap channels_values[4] = {
+    GapAdvChannelMapAll,
+    GapAdvChannelMap37,
+    GapAdvChannelMap38,
+    GapAdvChannelMap39,
+};
+const char* channels_names[4] = {"All", "37", "38", "39"};
+const char* mac_mode_names[4] = {"Fixed", "Random", "RPA", "Custom"};
+const uint32_t rpa_rotation_values[3] = {60000, 900000, 3600000};
+const char* rpa_rotation_names[3] = {"1min", "15min", "1h"};
+const char* remote_mode_names[2] = {"Off", "On"};
+const uint16_t multi_press_values[4] = {0, 200, 300, 500};
+const char* multi_press_names[4] = {"Off", "200ms", "300ms", "500ms"};
+const uint16_t long_press_values[3] = {300, 500, 800};
+const char* long_press_names[3] = {"300ms", "500ms", "800ms"};
+const char* hold_to_dim_names[2] = {"Off", "On"};
+const char* sensor_mode_names[3] = {"Off", "On", "On+Uptime"};
+const char* uart_bridge_names[2] = {"Off", "On"};
+const char* subghz_mirror_names[2] = {"Off", "On"};
+const char* coex_names[2] = {"Off", "On"};
+const NamePolicyOption name_policy_values[NAME_POLICY_COUNT] = {
+    {NamePolicyAlways, 0},
+    {NamePolicyFirst, 3},
+    {NamePolicyFirst, 10},
+    {NamePolicyShort, 4},
+    {NamePolicyShort, 8},
+};
+const char* name_policy_names[NAME_POLICY_COUNT] = {
+    "Always",
+    "First 3",
+    "First 10",
+    "Short 4",
+    "Short 8",
+};
 static const char DEVICE_NAME_KEY[] = "device_name";
+static const char NAME_POLICY_KEY[] = "bt_name_policy_idx";
 static const char BEACON_PERIOD_KEY[] = "bt_period_idx";
 static const char BEACON_DURATION_KEY[] = "bt_duration_idx";
+static const char ADV_SCHEDULE_KEY[] = "bt_adv_schedule";
+static const char SEND_COUNT_KEY[] = "bt_send_count_idx";
+static const char ADV_JITTER_KEY[] = "bt_adv_jitter_idx";
+static const char PROFILE_KEY[] = "bt_profile";
+static const char PROFILE_POWER_KEY_FMT[] = "bt_profile%u_power";
+static const char PROFILE_CHANNELS_KEY_FMT[] = "bt_profile%u_channels";
 static const char RANDOMIZE_MAC_KEY[] = "bt_randomize_mac";
+static const char RPA_ROTATION_KEY[] = "bt_rpa_rotation_idx";
+static const char IRK_KEY[] = "bt_irk";
+static const char CUSTOM_MAC_KEY[] = "bt_custom_mac";
+static const char REMOTE_MODE_KEY[] = "bt_remote_mode";
+static const char MULTI_PRESS_KEY[] = "bt_multi_press_idx";
+static const char LONG_PRESS_KEY[] = "bt_long_press_idx";
+static const char HOLD_TO_DIM_KEY[] = "bt_hold_to_dim";
+static const char SENSOR_MODE_KEY[] = "bt_sensor_mode";
+static const char UART_BRIDGE_KEY[] = "bt_uart_bridge";
+static const char SUBGHZ_MIRROR_KEY[] = "bt_subghz_mirror";
+static const char COEX_KEY[] = "bt_coex";
 
 /**
  * @brief      Save path, ssid and password to file on change.
@@ -20,6 +87,7 @@ static const char RANDOMIZE_MAC_KEY[] = "bt_randomize_mac";
 */
 void save_settings(App* app) {
     if(furi_mutex_acquire(app->config_mutex, FuriWaitForever) == FuriStatusOk) {
+        atrack_op_begin(AtrackOpSave);
         FURI_LOG_I(TAG, "Saving json config...");
         BtBeacon* bt_model = view_get_model(app->view_bt);
         Storage* storage = furi_record_open(RECORD_STORAGE);
@@ -40,9 +108,36 @@ void save_settings(App* app) {
 
             variable_item_set_current_value_text(app->device_name_item, bt_model->device_name);
         }
+        furi_json_add_entry(json, NAME_POLICY_KEY, (uint32_t)bt_model->name_policy_idx);
         furi_json_add_entry(json, BEACON_PERIOD_KEY, (uint32_t)bt_model->beacon_period_idx);
         furi_json_add_entry(json, BEACON_DURATION_KEY, (uint32_t)bt_model->beacon_duration_idx);
-        furi_json_add_entry(json, RANDOMIZE_MAC_KEY, (uint32_t)bt_model->randomize_mac_enb);
+        furi_json_add_entry(json, ADV_SCHEDULE_KEY, (uint32_t)bt_model->adv_schedule);
+        furi_json_add_entry(json, SEND_COUNT_KEY, (uint32_t)bt_model->send_count_idx);
+        furi_json_add_entry(json, ADV_JITTER_KEY, (uint32_t)bt_model->adv_jitter_idx);
+        furi_json_add_entry(json, PROFILE_KEY, (uint32_t)bt_model->profile_idx);
+        for(uint8_t i = 0; i < PROFILE_COUNT; i++) {
+            char key[24];
+            snprintf(key, sizeof(key), PROFILE_POWER_KEY_FMT, i);
+            furi_json_add_entry(json, key, (uint32_t)bt_model->profiles[i].tx_power_idx);
+            snprintf(key, sizeof(key), PROFILE_CHANNELS_KEY_FMT, i);
+            furi_json_add_entry(json, key, (uint32_t)bt_model->profiles[i].channels_idx);
+        }
+        furi_json_add_entry(json, RANDOMIZE_MAC_KEY, (uint32_t)bt_model->mac_mode);
+        furi_json_add_entry(json, RPA_ROTATION_KEY, (uint32_t)bt_model->rpa_rotation_idx);
+        char irk[RPA_IRK_SIZE * 2 + 1];
+        futils_bytes_to_hex(irk, bt_model->rpa.irk, RPA_IRK_SIZE);
+        furi_json_add_entry(json, IRK_KEY, (const char*)irk);
+        char custom_mac[EXTRA_BEACON_MAC_ADDR_SIZE * 2 + 1];
+        futils_bytes_to_hex(custom_mac, bt_model->custom_mac, EXTRA_BEACON_MAC_ADDR_SIZE);
+        furi_json_add_entry(json, CUSTOM_MAC_KEY, (const char*)custom_mac);
+        furi_json_add_entry(json, REMOTE_MODE_KEY, (uint32_t)bt_model->remote_mode_enb);
+        furi_json_add_entry(json, MULTI_PRESS_KEY, (uint32_t)bt_model->multi_press_idx);
+        furi_json_add_entry(json, LONG_PRESS_KEY, (uint32_t)bt_model->long_press_idx);
+        furi_json_add_entry(json, HOLD_TO_DIM_KEY, (uint32_t)bt_model->hold_to_dim_enb);
+        furi_json_add_entry(json, SENSOR_MODE_KEY, (uint32_t)bt_model->sensor_mode);
+        furi_json_add_entry(json, UART_BRIDGE_KEY, (uint32_t)app->uart_bridge_enb);
+        furi_json_add_entry(json, SUBGHZ_MIRROR_KEY, (uint32_t)bt_model->subghz_mirror_enb);
+        furi_json_add_entry(json, COEX_KEY, (uint32_t)bt_model->coex_enb);
 
         size_t len_w = 0;
         size_t len_req = strlen(json->to_text);
@@ -58,6 +153,7 @@ void save_settings(App* app) {
         furi_json_free(json);
         furi_record_close(RECORD_STORAGE);
         FURI_LOG_I(TAG, "Saving data completed, written %u bytes, buffer was %u", len_w, len_req);
+        atrack_op_end(AtrackOpSave);
         furi_check(furi_mutex_release(app->config_mutex) == FuriStatusOk);
     }
 }
@@ -67,6 +163,7 @@ void save_settings(App* app) {
  * @param      app  The context
 */
 void load_settings(App* app) {
+    atrack_op_begin(AtrackOpLoad);
     FURI_LOG_I(TAG, "Loading json config...");
     BtBeacon* bt_model = view_get_model(app->view_bt);
 
@@ -76,8 +173,8 @@ void load_settings(App* app) {
         storage_simply_mkdir(storage, BT_SETTINGS_FOLDER);
     }
     File* file = storage_file_alloc(storage);
-    size_t buf_size = 512;
-    uint8_t* file_buffer = malloc(buf_size);
+    size_t buf_size = 1024;
+    uint8_t* file_buffer = ATRACK_MALLOC(buf_size);
     FuriString* json = furi_string_alloc();
     uint16_t max_tokens = 128;
 
@@ -116,13 +213,23 @@ void load_settings(App* app) {
 
         bt_model->device_name_len = bt_model->default_name_len;
     }
-    free(value);
+    ATRACK_FREE(value);
 
+    value = get_json_value(NAME_POLICY_KEY, furi_string_get_cstr(json), max_tokens);
+    if(value) {
+        bt_model->name_policy_idx = strtoul(value, NULL, 10);
+        if(bt_model->name_policy_idx >= NAME_POLICY_COUNT) {
+            bt_model->name_policy_idx = 0;
+        }
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", NAME_POLICY_KEY);
+    }
     value = get_json_value(BEACON_PERIOD_KEY, furi_string_get_cstr(json), max_tokens);
     if(value) {
         bt_model->beacon_period_idx = strtoul(value, NULL, 10);
         bt_model->beacon_period = beacon_period_values[bt_model->beacon_period_idx];
-        free(value);
+        ATRACK_FREE(value);
     } else {
         FURI_LOG_I(
             TAG,
@@ -135,7 +242,7 @@ void load_settings(App* app) {
     if(value) {
         bt_model->beacon_duration_idx = strtoul(value, NULL, 10);
         bt_model->beacon_duration = beacon_duration_values[bt_model->beacon_duration_idx];
-        free(value);
+        ATRACK_FREE(value);
     } else {
         FURI_LOG_I(
             TAG,
@@ -144,29 +251,187 @@ void load_settings(App* app) {
             DEFAULT_BEACON_DURATION);
         bt_model->beacon_duration = DEFAULT_BEACON_DURATION;
     }
+    value = get_json_value(ADV_SCHEDULE_KEY, furi_string_get_cstr(json), max_tokens);
+    if(value) {
+        bt_model->adv_schedule = strtoul(value, NULL, 10);
+        if(bt_model->adv_schedule >= COUNT_OF(adv_schedule_names)) {
+            bt_model->adv_schedule = AdvScheduleFixed;
+        }
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", ADV_SCHEDULE_KEY);
+    }
+    value = get_json_value(SEND_COUNT_KEY, furi_string_get_cstr(json), max_tokens);
+    if(value) {
+        bt_model->send_count_idx = strtoul(value, NULL, 10);
+        if(bt_model->send_count_idx >= COUNT_OF(send_count_values)) {
+            bt_model->send_count_idx = 0;
+        }
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", SEND_COUNT_KEY);
+    }
+    bt_model->send_count = send_count_values[bt_model->send_count_idx];
+    value = get_json_value(ADV_JITTER_KEY, furi_string_get_cstr(json), max_tokens);
+    if(value) {
+        bt_model->adv_jitter_idx = strtoul(value, NULL, 10);
+        if(bt_model->adv_jitter_idx >= COUNT_OF(adv_jitter_values)) {
+            bt_model->adv_jitter_idx = 0;
+        }
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", ADV_JITTER_KEY);
+    }
+    value = get_json_value(PROFILE_KEY, furi_string_get_cstr(json), max_tokens);
+    if(value) {
+        bt_model->profile_idx = strtoul(value, NULL, 10);
+        if(bt_model->profile_idx >= PROFILE_COUNT) {
+            bt_model->profile_idx = 0;
+        }
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", PROFILE_KEY);
+    }
+    for(uint8_t i = 0; i < PROFILE_COUNT; i++) {
+        RadioProfile* profile = &bt_model->profiles[i];
+        char key[24];
+        // Missing entries keep the previous behaviour: +6dBm on all channels
+        profile->tx_power_idx = COUNT_OF(tx_power_values) - 1;
+        snprintf(key, sizeof(key), PROFILE_POWER_KEY_FMT, i);
+        value = get_json_value(key, furi_string_get_cstr(json), max_tokens);
+        if(value && strtoul(value, NULL, 10) < COUNT_OF(tx_power_values)) {
+            profile->tx_power_idx = strtoul(value, NULL, 10);
+        }
+        ATRACK_FREE(value);
+        snprintf(key, sizeof(key), PROFILE_CHANNELS_KEY_FMT, i);
+        value = get_json_value(key, furi_string_get_cstr(json), max_tokens);
+        if(value && strtoul(value, NULL, 10) < COUNT_OF(channels_values)) {
+            profile->channels_idx = strtoul(value, NULL, 10);
+        }
+        ATRACK_FREE(value);
+    }
+    bt_model->auto_power_idx = TX_POWER_AUTO + 1;
     value = get_json_value(RANDOMIZE_MAC_KEY, furi_string_get_cstr(json), max_tokens);
     if(value) {
         uint32_t index = strtoul(value, NULL, 10);
-        switch(index) {
-        case 0:
-            bt_model->randomize_mac_enb = false;
-            break;
-        case 1:
-            bt_model->randomize_mac_enb = true;
-            break;
-        default:
-            break;
+        if(index < COUNT_OF(mac_mode_names)) {
+            bt_model->mac_mode = index;
         }
-        free(value);
+        ATRACK_FREE(value);
     } else {
         FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", RANDOMIZE_MAC_KEY);
     }
+    value = get_json_value(RPA_ROTATION_KEY, furi_string_get_cstr(json), max_tokens);
+    if(value) {
+        bt_model->rpa_rotation_idx = strtoul(value, NULL, 10);
+        if(bt_model->rpa_rotation_idx >= COUNT_OF(rpa_rotation_values)) {
+            bt_model->rpa_rotation_idx = 0;
+        }
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", RPA_ROTATION_KEY);
+    }
+    // The IRK identifies the remote for its whole life, create it once and keep it
+    uint8_t irk[RPA_IRK_SIZE];
+    value = get_json_value(IRK_KEY, furi_string_get_cstr(json), max_tokens);
+    const bool irk_valid = value && futils_hex_to_bytes(value, irk, RPA_IRK_SIZE);
+    ATRACK_FREE(value);
+    if(!irk_valid) {
+        FURI_LOG_W(TAG, "Key [%s] missing or not valid, generating a new IRK.", IRK_KEY);
+        furi_hal_random_fill_buf(irk, RPA_IRK_SIZE);
+    }
+    rpa_set_irk(&bt_model->rpa, irk);
+    value = get_json_value(CUSTOM_MAC_KEY, furi_string_get_cstr(json), max_tokens);
+    if(!value || !futils_hex_to_bytes(value, bt_model->custom_mac, EXTRA_BEACON_MAC_ADDR_SIZE)) {
+        FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", CUSTOM_MAC_KEY);
+    }
+    ATRACK_FREE(value);
+    pretty_print_mac(bt_model->custom_mac_str, bt_model->custom_mac, EXTRA_BEACON_MAC_ADDR_SIZE);
+    value = get_json_value(REMOTE_MODE_KEY, furi_string_get_cstr(json), max_tokens);
+    if(value) {
+        bt_model->remote_mode_enb = strtoul(value, NULL, 10) == 1;
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", REMOTE_MODE_KEY);
+    }
+    value = get_json_value(MULTI_PRESS_KEY, furi_string_get_cstr(json), max_tokens);
+    bt_model->multi_press_idx = value ? strtoul(value, NULL, 10) : 0;
+    if(bt_model->multi_press_idx >= COUNT_OF(multi_press_values)) {
+        bt_model->multi_press_idx = 0;
+    }
+    bt_model->multi_press_window = multi_press_values[bt_model->multi_press_idx];
+    if(value) {
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_I(
+            TAG,
+            "Error: Key [%s] not found while loading config, using default value (%u).",
+            MULTI_PRESS_KEY,
+            DEFAULT_MULTI_PRESS);
+    }
+    value = get_json_value(LONG_PRESS_KEY, furi_string_get_cstr(json), max_tokens);
+    bt_model->long_press_idx = value ? strtoul(value, NULL, 10) : 1;
+    if(bt_model->long_press_idx >= COUNT_OF(long_press_values)) {
+        bt_model->long_press_idx = 1;
+    }
+    bt_model->long_press_time = long_press_values[bt_model->long_press_idx];
+    if(value) {
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_I(
+            TAG,
+            "Error: Key [%s] not found while loading config, using default value (%u).",
+            LONG_PRESS_KEY,
+            DEFAULT_LONG_PRESS);
+    }
+    value = get_json_value(HOLD_TO_DIM_KEY, furi_string_get_cstr(json), max_tokens);
+    if(value) {
+        bt_model->hold_to_dim_enb = strtoul(value, NULL, 10) == 1;
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", HOLD_TO_DIM_KEY);
+    }
+    value = get_json_value(SENSOR_MODE_KEY, furi_string_get_cstr(json), max_tokens);
+    if(value) {
+        bt_model->sensor_mode = strtoul(value, NULL, 10);
+        if(bt_model->sensor_mode >= COUNT_OF(sensor_mode_names)) {
+            bt_model->sensor_mode = SensorModeOff;
+        }
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", SENSOR_MODE_KEY);
+    }
+    value = get_json_value(UART_BRIDGE_KEY, furi_string_get_cstr(json), max_tokens);
+    if(value) {
+        app->uart_bridge_enb = strtoul(value, NULL, 10) == 1;
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", UART_BRIDGE_KEY);
+    }
+    value = get_json_value(SUBGHZ_MIRROR_KEY, furi_string_get_cstr(json), max_tokens);
+    if(value) {
+        bt_model->subghz_mirror_enb = strtoul(value, NULL, 10) == 1;
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", SUBGHZ_MIRROR_KEY);
+    }
+    value = get_json_value(COEX_KEY, furi_string_get_cstr(json), max_tokens);
+    if(value) {
+        bt_model->coex_enb = strtoul(value, NULL, 10) == 1;
+        ATRACK_FREE(value);
+    } else {
+        FURI_LOG_E(TAG, "Error: Key [%s] not found while loading config.", COEX_KEY);
+    }
 
-    free(file_buffer);
+    ATRACK_FREE(file_buffer);
     furi_string_free(json);
     storage_file_free(file);
     furi_record_close(RECORD_STORAGE);
     FURI_LOG_I(TAG, "Loading data completed");
+    atrack_op_end(AtrackOpLoad);
+    if(!irk_valid) {
+        save_settings(app);
+    }
 }
 
 /**
@@ -220,9 +485,24 @@ void submenu_callback(void* context, uint32_t index) {
     case SubmenuIndexBT:
         view_dispatcher_switch_to_view(app->view_dispatcher, ViewBt);
         break;
+    case SubmenuIndexSghz:
+        view_dispatcher_switch_to_view(app->view_dispatcher, ViewSghz);
+        break;
+    case SubmenuIndexTxLog:
+        view_dispatcher_switch_to_view(app->view_dispatcher, ViewTxLog);
+        break;
+    case SubmenuIndexConfigFile:
+        file_viewer_set_file(app->file_viewer, BT_CONF_PATH, BT_CONF_FILE_NAME);
+        view_dispatcher_switch_to_view(app->view_dispatcher, ViewResp);
+        break;
     case SubmenuIndexAbout:
         view_dispatcher_switch_to_view(app->view_dispatcher, ViewAbout);
         break;
+#if ALLOC_TRACKER
+    case SubmenuIndexHeapStats:
+        view_dispatcher_switch_to_view(app->view_dispatcher, ViewHeapStats);
+        break;
+#endif
     default:
         break;
     }
@@ -239,6 +519,12 @@ void variable_item_setting_changed(VariableItem* item) {
     uint8_t index = variable_item_list_get_selected_item_index(app->variable_item_list_config);
     FURI_LOG_I(TAG, "Index %u", index);
     switch(index) {
+    case ConfigVariableItemNamePolicy:
+        bt_model->name_policy_idx = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(item, name_policy_names[bt_model->name_policy_idx]);
+        // A new count starts, so First N sends the name again
+        bt_model->name_presses = 0;
+        break;
     case ConfigVariableItemBeaconPeriod:
         bt_model->beacon_period_idx = variable_item_get_current_value_index(item);
         variable_item_set_current_value_text(
@@ -251,10 +537,102 @@ void variable_item_setting_changed(VariableItem* item) {
             item, beacon_duration_names[bt_model->beacon_duration_idx]);
         bt_model->beacon_duration = beacon_duration_values[bt_model->beacon_duration_idx];
         break;
-    case ConfigVariableItemRandomizeMac:
-        bt_model->randomize_mac_enb = variable_item_get_current_value_index(item);
+    case ConfigVariableItemAdvSchedule:
+        bt_model->adv_schedule = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(item, adv_schedule_names[bt_model->adv_schedule]);
+        break;
+    case ConfigVariableItemSendCount:
+        bt_model->send_count_idx = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(item, send_count_names[bt_model->send_count_idx]);
+        bt_model->send_count = send_count_values[bt_model->send_count_idx];
+        break;
+    case ConfigVariableItemAdvJitter:
+        bt_model->adv_jitter_idx = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(item, adv_jitter_names[bt_model->adv_jitter_idx]);
+        break;
+    case ConfigVariableItemProfile: {
+        bt_model->profile_idx = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(item, profile_names[bt_model->profile_idx]);
+        // Show the settings of the selected profile
+        const RadioProfile* profile = &bt_model->profiles[bt_model->profile_idx];
+        variable_item_set_current_value_index(app->tx_power_item, profile->tx_power_idx);
+        variable_item_set_current_value_text(
+            app->tx_power_item, tx_power_names[profile->tx_power_idx]);
+        variable_item_set_current_value_index(app->channels_item, profile->channels_idx);
         variable_item_set_current_value_text(
-            item, randomize_mac_names[variable_item_get_current_value_index(item)]);
+            app->channels_item, channels_names[profile->channels_idx]);
+        bt_model->auto_power_idx = TX_POWER_AUTO + 1;
+        break;
+    }
+    case ConfigVariableItemTxPower:
+        bt_model->profiles[bt_model->profile_idx].tx_power_idx =
+            variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(
+            item, tx_power_names[variable_item_get_current_value_index(item)]);
+        bt_model->auto_power_idx = TX_POWER_AUTO + 1;
+        break;
+    case ConfigVariableItemChannels:
+        bt_model->profiles[bt_model->profile_idx].channels_idx =
+            variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(
+            item, channels_names[variable_item_get_current_value_index(item)]);
+        break;
+    case ConfigVariableItemMacMode:
+        bt_model->mac_mode = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(item, mac_mode_names[bt_model->mac_mode]);
+        bt_set_address(bt_model);
+        break;
+    case ConfigVariableItemRpaRotation:
+        bt_model->rpa_rotation_idx = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(
+            item, rpa_rotation_names[bt_model->rpa_rotation_idx]);
+        break;
+    case ConfigVariableItemRemoteMode:
+        bt_model->remote_mode_enb = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(
+            item, remote_mode_names[variable_item_get_current_value_index(item)]);
+        break;
+    case ConfigVariableItemMultiPress:
+        bt_model->multi_press_idx = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(item, multi_press_names[bt_model->multi_press_idx]);
+        bt_model->multi_press_window = multi_press_values[bt_model->multi_press_idx];
+        bt_gesture_configure(app);
+        break;
+    case ConfigVariableItemLongPress:
+        bt_model->long_press_idx = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(item, long_press_names[bt_model->long_press_idx]);
+        bt_model->long_press_time = long_press_values[bt_model->long_press_idx];
+        bt_gesture_configure(app);
+        break;
+    case ConfigVariableItemHoldToDim:
+        bt_model->hold_to_dim_enb = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(
+            item, hold_to_dim_names[variable_item_get_current_value_index(item)]);
+        break;
+    case ConfigVariableItemSensorMode:
+        bt_model->sensor_mode = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(item, sensor_mode_names[bt_model->sensor_mode]);
+        break;
+    case ConfigVariableItemUartBridge:
+        app->uart_bridge_enb = variable_item_get_current_value_index(item);
+        bt_uart_bridge_update(app);
+        // The USART may be busy, show what actually happened
+        app->uart_bridge_enb = app->uart_bridge != NULL;
+        variable_item_set_current_value_index(item, app->uart_bridge_enb);
+        variable_item_set_current_value_text(item, uart_bridge_names[app->uart_bridge_enb]);
+        break;
+    case ConfigVariableItemSubghzMirror:
+        if(variable_item_get_current_value_index(item)) {
+            // Re-read the key file, so edits are picked up without restarting the app
+            subghz_mirror_load(bt_model->subghz, BT_SUBGHZ_PATH);
+        }
+        bt_model->subghz_mirror_enb = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(
+            item, subghz_mirror_names[bt_model->subghz_mirror_enb]);
+        break;
+    case ConfigVariableItemCoex:
+        bt_model->coex_enb = variable_item_get_current_value_index(item);
+        variable_item_set_current_value_text(item, coex_names[bt_model->coex_enb]);
         break;
 
     default:
@@ -264,6 +642,23 @@ void variable_item_setting_changed(VariableItem* item) {
     save_settings(app);
 }
 
+/**
+ * @brief      Validator of the custom MAC text input.
+ * @param      text     The text to check.
+ * @param      error    The message shown when the text is not valid.
+ * @param      context  The context - unused
+ * @return     true if the text is a valid MAC
+*/
+bool mac_validator(const char* text, FuriString* error, void* context) {
+    UNUSED(context);
+    uint8_t address[EXTRA_BEACON_MAC_ADDR_SIZE];
+    if(!parse_mac(text, address)) {
+        furi_string_set_str(error, "Need 12 hex\ndigits");
+        return false;
+    }
+    return true;
+}
+
 /**
  * @brief      Function called when one of the texts is updated.
  * @param      context  The context - App object.
@@ -282,8 +677,18 @@ void conf_text_updated(void* context) {
             "conf_text_updated",
             "bt_model->device_name");
         bt_model->device_name_len = strlen(bt_model->device_name);
+        bt_model->name_presses = 0;
         variable_item_set_current_value_text(app->device_name_item, bt_model->device_name);
         break;
+    case ConfigTextInputCustomMac:
+        // Already checked by the validator
+        parse_mac(app->temp_custom_mac, bt_model->custom_mac);
+        pretty_print_mac(
+            bt_model->custom_mac_str, bt_model->custom_mac, EXTRA_BEACON_MAC_ADDR_SIZE);
+        variable_item_set_current_value_text(
+            app->custom_mac_item, furi_string_get_cstr(bt_model->custom_mac_str));
+        bt_set_address(bt_model);
+        break;
     default:
         FURI_LOG_E(TAG, "Unhandled index [%lu] in conf_text_updated.", app->config_index);
         return;
@@ -319,6 +724,28 @@ void setting_item_clicked(void* context, uint32_t index) {
         text_input_set_header_text(text_input, "Device Name:"),
             view_index = ViewTextInputDeviceName;
         break;
+    case ConfigTextInputCustomMac:
+        // Hex input needs the full keyboard, so this one uses the UART text input
+        futils_copy_str(
+            app->temp_custom_mac,
+            furi_string_get_cstr(bt_model->custom_mac_str),
+            MAC_STR_SIZE,
+            "setting_items_clicked",
+            "app->temp_custom_mac");
+        uart_text_input_set_header_text(app->text_input_custom_mac, "MAC (AA:BB:CC:DD:EE:FF):");
+        uart_text_input_set_validator(app->text_input_custom_mac, mac_validator, NULL);
+        uart_text_input_set_result_callback(
+            app->text_input_custom_mac,
+            conf_text_updated,
+            app,
+            app->temp_custom_mac,
+            MAC_STR_SIZE,
+            false);
+        view_set_previous_callback(
+            uart_text_input_get_view(app->text_input_custom_mac), navigation_configure_callback);
+        app->config_index = index;
+        view_dispatcher_switch_to_view(app->view_dispatcher, ViewTextInputCustomMac);
+        return;
     default:
         // don't handle presses that are not explicitly defined in the enum
         return;
@@ -369,6 +796,10 @@ bool view_custom_event_callback(uint32_t event, void* context) {
     case EventIdForceBack:
         view_dispatcher_switch_to_view(app->view_dispatcher, ViewSubmenu);
         return true;
+    case EventIdGestureTick:
+        gesture_tick(&app->gesture, furi_get_tick());
+        bt_gesture_rearm(app);
+        return true;
     default:
         return false;
     }
@@ -11,14 +11,33 @@
 #include <gui/view.h>
 #include <gui/view_dispatcher.h>
 #include <libs/easy_flipper.h>
+#include <libs/alloc_tracker.h>
+#include "src/gesture.h"
+#include "src/macro.h"
+#include "src/rpa.h"
+#include "src/command.h"
+#include "src/uart_bridge.h"
+#include "src/subghz_mirror.h"
+#include "src/counter_store.h"
+#include "src/tx_log.h"
+#include "src/file_viewer.h"
+#include "src/adv_inspect.h"
+#include "src/adv_sched.h"
 
 #define TAG                 "BT_HOME_REMOTE"
 #define BT_APPS_DATA_FOLDER EXT_PATH("apps_data")
 #define BT_SETTINGS_FOLDER  \
     BT_APPS_DATA_FOLDER "/" \
                         "bt_home_remote"
-#define BT_CONF_FILE_NAME "conf.json"
-#define BT_CONF_PATH      BT_SETTINGS_FOLDER "/" BT_CONF_FILE_NAME
+#define BT_CONF_FILE_NAME    "conf.json"
+#define BT_CONF_PATH         BT_SETTINGS_FOLDER "/" BT_CONF_FILE_NAME
+#define BT_MACRO_PATH        BT_SETTINGS_FOLDER "/" MACRO_FILE_NAME
+#define BT_SUBGHZ_PATH       BT_SETTINGS_FOLDER "/" SUBGHZ_MIRROR_FILE_NAME
+#define BT_COUNTER_PATH      BT_SETTINGS_FOLDER "/" COUNTER_FILE_NAME
+#define BT_TX_LOG_PATH       BT_SETTINGS_FOLDER "/" TX_LOG_FILE_NAME
+#define BT_TX_LOG_INDEX_PATH BT_SETTINGS_FOLDER "/" TX_LOG_INDEX_NAME
+
+#define MAC_STR_SIZE 18 // "AA:BB:CC:DD:EE:FF"
 
 #define INPUT_RESET      0xFF
 #define DRAW_PERIOD      100U
@@ -26,36 +45,85 @@
 
 #define DEFAULT_BEACON_PERIOD   20U
 #define DEFAULT_BEACON_DURATION 1000U
+#define DEFAULT_MULTI_PRESS     0U
+#define DEFAULT_LONG_PRESS      500U
+
+// A dimmer update stays on air for at least this many advertising events
+#define DIMMER_MIN_ADV_EVENTS 3U
+#define DIMMER_MAX_STEPS      255
+
+// Radio profiles, auto power steps up when a press is repeated within AUTO_POWER_REPEAT
+#define PROFILE_COUNT       4
+#define TX_POWER_AUTO       0 // Index of the auto entry in the TX power list
+#define AUTO_POWER_REPEAT   3000U
+#define AUTO_POWER_SETTLE   600000U // Step back down after this long without presses
+
+#define CMD_QUEUE_SIZE 16 // External commands waiting for the comm worker
 
-#define MAX_NAME_LENGHT 15
+#define SENSOR_REFRESH_PERIOD 5000U
+#define SENSOR_ADV_INTERVAL   1000U
+// Deadbands, readings closer than these to the last sent ones don't update the beacon
+#define SENSOR_DB_BATTERY     1U // %
+#define SENSOR_DB_TEMPERATURE 50U // 0.01 °C
+#define SENSOR_DB_VOLTAGE     20U // mV
+#define SENSOR_DB_UPTIME      60U // s
+
+#define MAX_NAME_LENGHT    15
+#define NAME_POLICY_COUNT  5
+#define NAME_POLICY_ALWAYS 0 // Index of the always entry in the name policy list
 
 typedef enum {
     SubmenuIndexConfigure,
     SubmenuIndexBT,
+    SubmenuIndexSghz,
+    SubmenuIndexTxLog,
+    SubmenuIndexConfigFile,
     SubmenuIndexAbout,
+    SubmenuIndexHeapStats,
 } SubmenuIndex;
 
 typedef enum {
     ViewSubmenu, // The menu when the app starts
     ViewTextInputDeviceName,
+    ViewTextInputCustomMac,
     ViewConfigure, // The configuration screen
     ViewBt,
     ViewSghz,
     ViewResp,
     ViewAbout,
+    ViewTxLog,
+    ViewHeapStats,
 } ViewEnum;
 
 typedef enum {
     ConfigTextInputDeviceName,
+    ConfigVariableItemNamePolicy,
     ConfigVariableItemBeaconPeriod,
     ConfigVariableItemBeaconDuration,
-    ConfigVariableItemRandomizeMac,
+    ConfigVariableItemAdvSchedule,
+    ConfigVariableItemSendCount,
+    ConfigVariableItemAdvJitter,
+    ConfigVariableItemProfile,
+    ConfigVariableItemTxPower,
+    ConfigVariableItemChannels,
+    ConfigVariableItemMacMode,
+    ConfigVariableItemRpaRotation,
+    ConfigTextInputCustomMac,
+    ConfigVariableItemRemoteMode,
+    ConfigVariableItemMultiPress,
+    ConfigVariableItemLongPress,
+    ConfigVariableItemHoldToDim,
+    ConfigVariableItemSensorMode,
+    ConfigVariableItemUartBridge,
+    ConfigVariableItemSubghzMirror,
+    ConfigVariableItemCoex,
 } ConfigIndex;
 
 typedef enum {
     EventIdBtRedrawScreen = 3, // Custom event to redraw the screen
     EventIdBtCheckBack = 23,
     EventIdForceBack = 29,
+    EventIdGestureTick = 31, // A multi press window or long press hold expired
 } EventId;
 
 typedef enum {
@@ -63,10 +131,88 @@ typedef enum {
     BEACON_BUSY,
 } BeaconStatus;
 
+typedef enum {
+    BtPacketButton,
+    BtPacketDimmer,
+    BtPacketSensor,
+} BtPacketKind;
+
+typedef struct {
+    uint32_t count;
+    uint32_t min; // ticks
+    uint32_t max;
+    uint32_t sum;
+} BtLatencyStats; // From the press to the packet handed to the radio
+
+typedef struct {
+    uint8_t tx_power_idx; // TX_POWER_AUTO or a fixed level
+    uint8_t channels_idx;
+} RadioProfile;
+
+typedef enum {
+    NamePolicyAlways,
+    NamePolicyFirst, // Only the first presses after boot or a name change
+    NamePolicyShort, // Shortened name, cut to a byte budget
+} NamePolicy;
+
+typedef struct {
+    uint8_t policy;
+    uint8_t limit; // Presses for NamePolicyFirst, name bytes for NamePolicyShort
+} NamePolicyOption;
+
+typedef struct {
+    uint8_t offset_ms; // Max random delay before the beacon starts
+    uint8_t interval_pct; // Max random increase of the advertising interval
+} AdvJitter;
+
+typedef enum {
+    CoexOwnerNone,
+    CoexOwnerApp,
+    CoexOwnerPrev, // The extra beacon that was running when the app started
+} CoexOwner;
+
+typedef struct {
+    uint8_t owner; // CoexOwner of the beacon on air
+    uint32_t since; // Tick of the last owner change
+    uint16_t interval_ms; // Of the beacon on air, for the air time estimate
+    uint8_t data_len;
+    uint8_t channels;
+    uint32_t on_air_ms[3]; // Per CoexOwner
+    uint32_t air_ms[3]; // Estimated radio air time per CoexOwner
+    uint32_t restores;
+} CoexStats;
+
+typedef enum {
+    MacModeFixed,
+    MacModeRandom,
+    MacModeRpa, // Resolvable private address from the IRK
+    MacModeCustom,
+} MacMode;
+
+typedef enum {
+    AdvScheduleFixed,
+    AdvScheduleAdaptive,
+} AdvSchedule;
+
+typedef enum {
+    SensorModeOff,
+    SensorModeOn,
+    SensorModeUptime, // Also report the uptime
+} SensorMode;
+
+typedef struct {
+    uint8_t battery; // %
+    int16_t temperature; // 0.01 °C
+    uint16_t voltage; // mV
+    uint32_t uptime; // s
+} BtSensorReadings;
+
 typedef enum {
     PageFirst,
     PageSecond,
     PageThird,
+    PageInspector,
+    PageMacro,
     PageLast,
 } PageIndex;
 
@@ -76,6 +222,13 @@ typedef enum {
     ThreadCommSendCmd = 0b00000100,
     ThreadCommStopCmd = 0b00001000,
     ThreadCommSendCmdBt = 0b00010000,
+    ThreadCommResume = 0b00100000,
+    ThreadCommSuspend = 0b01000000,
+    ThreadCommDimCmd = 0b10000000,
+    ThreadCommMacroCmd = 0b100000000, // Start or stop the macro
+    ThreadCommSensorCmd = 0b1000000000, // Refresh the sensor readings
+    ThreadCommRpaCmd = 0b10000000000, // Rotate the resolvable private address
+    ThreadCommExtCmd = 0b100000000000, // Commands waiting in cmd_queue
 } EventCommReq;
 
 typedef struct App {
@@ -84,7 +237,13 @@ typedef struct App {
     VariableItemList* variable_item_list_config; // The configuration screen
     View* view_bt;
     uint8_t current_view;
+    View* view_sghz; // Sub-GHz mirror status
+    View* view_tx_log; // Events per day from the transmission log
+    FileViewer* file_viewer; // Text files, read a screen at a time
     Widget* widget_about; // The about screen
+#if ALLOC_TRACKER
+    View* view_heap_stats; // Allocation tracker debug screen
+#endif
     FuriMutex* config_mutex;
 
     uint32_t config_index;
@@ -92,15 +251,40 @@ typedef struct App {
     TextInput* text_input_device_name;
     char* temp_device_name; // Temporary buffer for text input
     size_t temp_device_name_size; // Size of temporary buffer
+    UART_TextInput* text_input_custom_mac;
+    char temp_custom_mac[MAC_STR_SIZE]; // Temporary buffer for the custom MAC input
     VariableItem* device_name_item;
+    VariableItem* name_policy_item;
     VariableItem* beacon_period_item;
     VariableItem* beacon_duration_item;
-    VariableItem* randomize_mac_enb_item;
+    VariableItem* adv_schedule_item;
+    VariableItem* send_count_item;
+    VariableItem* adv_jitter_item;
+    VariableItem* profile_item;
+    VariableItem* tx_power_item;
+    VariableItem* channels_item;
+    VariableItem* mac_mode_item;
+    VariableItem* rpa_rotation_item;
+    VariableItem* custom_mac_item;
+    VariableItem* remote_mode_enb_item;
+    VariableItem* multi_press_item;
+    VariableItem* long_press_item;
+    VariableItem* hold_to_dim_item;
+    VariableItem* sensor_mode_item;
+    VariableItem* uart_bridge_item;
+    VariableItem* subghz_mirror_item;
+    VariableItem* coex_item;
 
     FuriTimer* timer_draw; // Timer for redrawing the screen
     FuriTimer* timer_reset_key;
+    FuriTimer* timer_gesture;
+    Gesture gesture; // Only touched from the GUI thread
     FuriThreadId comm_thread_id;
     FuriThread* comm_thread;
+    volatile bool bt_view_active; // Worker is parked while false
+    FuriMessageQueue* cmd_queue; // Cmd from the UART bridge, run by the comm worker
+    UartBridge* uart_bridge; // NULL while disabled
+    bool uart_bridge_enb;
     FuriTimer* timer_comm_upd;
 } App;
 
@@ -118,22 +302,78 @@ typedef struct {
     uint8_t prev_data_len;
     bool prev_active;
     bool prev_exists;
+    bool coex_enb; // Keep the previous beacon on air between our events
+    CoexStats coex;
     // BR Home Data
-    uint8_t cnt;
+    uint8_t cnt; // Packet id of the last packet, low byte of the persisted counter
+    CounterStore* counter;
+    TxLog* tx_log; // Every packet sent
     char* device_name;
     size_t device_name_len;
+    uint8_t name_policy_idx;
+    uint8_t name_presses; // Presses sent since boot or the last name change
+    uint32_t name_saved_bytes; // Left out by the name policy, against always sending it
     int8_t curr_page;
+    AdvInspect inspect; // Decoded packet on air, rebuilt only when the data changes
+    uint8_t inspect_top; // First line shown on the inspector page
     uint8_t event_type;
+    uint8_t button_idx;
+    uint8_t packet_kind;
+    // Dimmer
+    bool hold_to_dim_enb; // Up/Down stream dimmer steps while held
+    int16_t dim_acc; // Steps not sent yet, positive is rotate right
+    uint8_t dim_event;
+    uint8_t dim_steps;
+    uint32_t dim_last_tick;
+    FuriTimer* timer_dim;
+    Macro* macro;
+    SubghzMirror* subghz; // Keys sent along with the button events
+    bool subghz_mirror_enb;
+    // Sensor broadcast
+    uint8_t sensor_mode;
+    bool sensor_valid; // sensor_sent holds readings
+    bool sensor_on_air; // The beacon runs with the sensor config
+    BtSensorReadings sensor_sent;
+    uint32_t sensor_updates;
+    uint32_t sensor_skipped;
+    FuriTimer* timer_sensor;
     // Beacon settings
     GapExtraBeaconConfig config;
     uint16_t beacon_period;
     uint16_t beacon_duration;
     uint8_t beacon_period_idx;
     uint8_t beacon_duration_idx;
-    bool randomize_mac_enb;
+    uint8_t adv_schedule;
+    uint8_t send_count; // Advertising events per event, 0 uses beacon_duration
+    uint8_t send_count_idx;
+    uint8_t adv_jitter_idx; // Random start offset and interval, so remotes don't stay in step
+    bool start_pending; // The beacon is configured and starts once the offset is over
+    uint32_t start_due; // Tick of the pending start
+    AdvSched sched; // Advertising schedule of the current event
+    RadioProfile profiles[PROFILE_COUNT];
+    uint8_t profile_idx;
+    uint8_t auto_power_idx; // Level learned by the auto mode
+    uint32_t last_press_tick;
+    uint32_t press_tick; // When the D-pad event was requested
+    BtLatencyStats latency;
+    uint8_t last_press_button;
+    uint8_t last_press_event;
+    uint8_t mac_mode;
+    uint8_t rpa_rotation_idx;
+    uint8_t custom_mac[EXTRA_BEACON_MAC_ADDR_SIZE]; // MSB first, as typed
+    FuriString* custom_mac_str;
+    Rpa rpa; // IRK and its cached key expansion
+    bool rpa_pending; // Rotation due, applied when no event is on air
+    FuriTimer* timer_rpa;
+    bool remote_mode_enb; // Every D-pad key is its own BTHome button
+    uint16_t multi_press_window;
+    uint16_t long_press_time;
+    uint8_t multi_press_idx;
+    uint8_t long_press_idx;
 } BtBeacon;
 
 void save_settings(App* app);
+bool mac_validator(const char* text, FuriString* error, void* context);
 void load_settings(App* app);
 void variable_item_setting_changed(VariableItem* item);
 void conf_text_updated(void* context);
@@ -0,0 +1,208 @@
+#include "alloc_tracker.h"
+
+const char* atrack_op_names[AtrackOpCount] = {"None", "Press", "Save", "Load", "View Enter"};
+
+#if ALLOC_TRACKER
+typedef struct {
+    void* ptr;
+    uint32_t size;
+    uint8_t site;
+    uint16_t op_gen; // Operation that made the allocation, 0 if none
+} AtrackEntry;
+
+static AtrackStats stats;
+static AtrackEntry live[ALLOC_TRACKER_MAX_LIVE];
+static AtrackOp curr_op = AtrackOpNone;
+static FuriThreadId op_thread;
+static uint16_t op_gen;
+static uint32_t op_live;
+
+/**
+ * @brief       Find or register the stats slot of a call site, must be called in a critical section
+ * @param       site  name of the calling function
+ * @return      the slot index, the last slot collects any overflow
+*/
+static uint8_t atrack_site_index(const char* site) {
+    for(uint8_t i = 0; i < stats.site_count; i++) {
+        if(stats.sites[i].name == site) {
+            return i;
+        }
+    }
+    if(stats.site_count < ALLOC_TRACKER_MAX_SITES) {
+        stats.sites[stats.site_count].name = site;
+        return stats.site_count++;
+    }
+    stats.sites[ALLOC_TRACKER_MAX_SITES - 1].name = "other";
+    return ALLOC_TRACKER_MAX_SITES - 1;
+}
+
+/**
+ * @brief       Account a new allocation, must be called in a critical section
+*/
+static void atrack_add(void* ptr, size_t size, const char* site) {
+    uint8_t idx = atrack_site_index(site);
+    AtrackSiteStats* s = &stats.sites[idx];
+    s->count++;
+    s->live_bytes += size;
+    s->peak_bytes = MAX(s->peak_bytes, s->live_bytes);
+
+    stats.count++;
+    stats.live_bytes += size;
+    stats.peak_bytes = MAX(stats.peak_bytes, stats.live_bytes);
+
+    // Other threads keep running during an operation, they are not part of it
+    const bool in_op = curr_op != AtrackOpNone && furi_thread_get_current_id() == op_thread;
+    if(in_op) {
+        AtrackOpStats* op = &stats.ops[curr_op];
+        op->count++;
+        op->bytes += size;
+        op_live += size;
+        op->peak_bytes = MAX(op->peak_bytes, op_live);
+    }
+
+    for(size_t i = 0; i < ALLOC_TRACKER_MAX_LIVE; i++) {
+        if(live[i].ptr == NULL) {
+            live[i].ptr = ptr;
+            live[i].size = size;
+            live[i].site = idx;
+            live[i].op_gen = in_op ? op_gen : 0;
+            return;
+        }
+    }
+    stats.untracked++;
+}
+
+/**
+ * @brief       Remove an allocation from the accounting, must be called in a critical section
+ * @details     Pointers not allocated through the tracker are silently ignored.
+*/
+static void atrack_remove(void* ptr) {
+    for(size_t i = 0; i < ALLOC_TRACKER_MAX_LIVE; i++) {
+        if(live[i].ptr == ptr) {
+            stats.sites[live[i].site].live_bytes -= live[i].size;
+            stats.live_bytes -= live[i].size;
+            if(live[i].op_gen != 0 && live[i].op_gen == op_gen && curr_op != AtrackOpNone) {
+                op_live -= live[i].size;
+            }
+            live[i].ptr = NULL;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief       Account a block moved or resized by realloc, must be called in a critical section
+ * @details     The block keeps its call site and operation, only its size changes. Pointers not
+ *              allocated through the tracker are accounted as a new allocation.
+*/
+static void atrack_resize(void* ptr, void* new_ptr, size_t size, const char* site) {
+    for(size_t i = 0; i < ALLOC_TRACKER_MAX_LIVE; i++) {
+        if(live[i].ptr == ptr) {
+            const uint32_t old_size = live[i].size;
+            AtrackSiteStats* s = &stats.sites[live[i].site];
+            s->live_bytes = s->live_bytes - old_size + size;
+            s->peak_bytes = MAX(s->peak_bytes, s->live_bytes);
+
+            stats.live_bytes = stats.live_bytes - old_size + size;
+            stats.peak_bytes = MAX(stats.peak_bytes, stats.live_bytes);
+
+            if(live[i].op_gen != 0 && live[i].op_gen == op_gen && curr_op != AtrackOpNone) {
+                AtrackOpStats* op = &stats.ops[curr_op];
+                op->bytes += size > old_size ? size - old_size : 0;
+                op_live = op_live - old_size + size;
+                op->peak_bytes = MAX(op->peak_bytes, op_live);
+            }
+
+            live[i].ptr = new_ptr;
+            live[i].size = size;
+            return;
+        }
+    }
+    atrack_add(new_ptr, size, site);
+}
+
+void* atrack_malloc(size_t size, const char* site) {
+    void* ptr = malloc(size);
+    if(ptr) {
+        FURI_CRITICAL_ENTER();
+        atrack_add(ptr, size, site);
+        FURI_CRITICAL_EXIT();
+    }
+    return ptr;
+}
+
+void* atrack_realloc(void* ptr, size_t size, const char* site) {
+    void* new_ptr = realloc(ptr, size);
+    if(new_ptr) {
+        FURI_CRITICAL_ENTER();
+        if(ptr) {
+            atrack_resize(ptr, new_ptr, size, site);
+        } else {
+            atrack_add(new_ptr, size, site);
+        }
+        FURI_CRITICAL_EXIT();
+    }
+    return new_ptr;
+}
+
+void atrack_free(void* ptr) {
+    if(ptr) {
+        FURI_CRITICAL_ENTER();
+        atrack_remove(ptr);
+        FURI_CRITICAL_EXIT();
+    }
+    free(ptr);
+}
+
+/**
+ * @brief       Start accounting allocations to an user operation
+ * @details     Only the allocations of the calling thread are accounted to the operation.
+ * @param       op  the operation
+*/
+void atrack_op_begin(AtrackOp op) {
+    const FuriThreadId thread = furi_thread_get_current_id();
+    FURI_CRITICAL_ENTER();
+    curr_op = op;
+    op_thread = thread;
+    op_live = 0;
+    if(++op_gen == 0) {
+        op_gen = 1;
+    }
+    stats.ops[op].count = 0;
+    stats.ops[op].bytes = 0;
+    stats.ops[op].peak_bytes = 0;
+    stats.ops[op].leaked_bytes = 0;
+    FURI_CRITICAL_EXIT();
+}
+
+/**
+ * @brief       Stop accounting allocations to an user operation
+ * @param       op  the operation, ignored if it's not the current one
+*/
+void atrack_op_end(AtrackOp op) {
+    FURI_CRITICAL_ENTER();
+    if(curr_op == op) {
+        stats.ops[op].leaked_bytes = (int32_t)op_live;
+        curr_op = AtrackOpNone;
+    }
+    FURI_CRITICAL_EXIT();
+    FURI_LOG_D(
+        ALLOC_TRACKER_TAG,
+        "%s: %lu allocs, %lu bytes, peak %lu, leaked %ld",
+        atrack_op_names[op],
+        stats.ops[op].count,
+        stats.ops[op].bytes,
+        stats.ops[op].peak_bytes,
+        stats.ops[op].leaked_bytes);
+}
+
+/**
+ * @brief       Copy a consistent snapshot of the stats
+ * @param       out  destination
+*/
+void atrack_get_stats(AtrackStats* out) {
+    FURI_CRITICAL_ENTER();
+    memcpy(out, &stats, sizeof(AtrackStats));
+    FURI_CRITICAL_EXIT();
+}
+#endif
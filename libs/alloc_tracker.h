@@ -0,0 +1,68 @@
+#pragma once
+#include <furi.h>
+#include <stdlib.h>
+
+// Opt-in heap accounting. Enable with cdefines=["ALLOC_TRACKER=1"] in application.fam.
+// Only the allocations made through ATRACK_MALLOC/ATRACK_REALLOC/ATRACK_FREE are seen, the SDK
+// and the vendored libs keep the plain allocator.
+#ifndef ALLOC_TRACKER
+#define ALLOC_TRACKER false
+#endif
+
+#define ALLOC_TRACKER_TAG       "ALLOC_TRACKER"
+#define ALLOC_TRACKER_MAX_SITES 24
+#define ALLOC_TRACKER_MAX_LIVE  96
+
+typedef enum {
+    AtrackOpNone,
+    AtrackOpPress,
+    AtrackOpSave,
+    AtrackOpLoad,
+    AtrackOpViewEnter,
+    AtrackOpCount,
+} AtrackOp;
+
+typedef struct {
+    const char* name;
+    uint32_t count;
+    uint32_t live_bytes;
+    uint32_t peak_bytes;
+} AtrackSiteStats;
+
+typedef struct {
+    uint32_t count;
+    uint32_t bytes;
+    uint32_t peak_bytes;
+    int32_t leaked_bytes;
+} AtrackOpStats;
+
+typedef struct {
+    uint32_t count;
+    uint32_t live_bytes;
+    uint32_t peak_bytes;
+    uint32_t untracked;
+    uint8_t site_count;
+    AtrackSiteStats sites[ALLOC_TRACKER_MAX_SITES];
+    AtrackOpStats ops[AtrackOpCount];
+} AtrackStats;
+
+extern const char* atrack_op_names[AtrackOpCount];
+
+#if ALLOC_TRACKER
+void* atrack_malloc(size_t size, const char* site);
+void* atrack_realloc(void* ptr, size_t size, const char* site);
+void atrack_free(void* ptr);
+void atrack_op_begin(AtrackOp op);
+void atrack_op_end(AtrackOp op);
+void atrack_get_stats(AtrackStats* stats);
+
+#define ATRACK_MALLOC(size)       atrack_malloc(size, __func__)
+#define ATRACK_REALLOC(ptr, size) atrack_realloc(ptr, size, __func__)
+#define ATRACK_FREE(ptr)          atrack_free(ptr)
+#else
+#define ATRACK_MALLOC(size)       malloc(size)
+#define ATRACK_REALLOC(ptr, size) realloc(ptr, size)
+#define ATRACK_FREE(ptr)          free(ptr)
+#define atrack_op_begin(op)
+#define atrack_op_end(op)
+#endif
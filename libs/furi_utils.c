@@ -1,5 +1,8 @@
 #include "furi_utils.h"
 #include <furi_hal.h>
+#include <storage/storage.h>
+#include "json_pretty.h"
+#include "random_below.h"
 
 /**
  * @brief       Buzz the vibration for n ms
@@ -10,6 +13,105 @@ void futils_buzz_vibration(uint32_t ms) {
     furi_hal_vibro_on(false);
 }
 
+#define FUTILS_RNG_HALF (FUTILS_RNG_POOL_WORDS / 2)
+
+// Words from the hardware RNG, handed out in order. When a half is used up it is refilled in the
+// timer thread while the other half is in use, so draws don't wait for the RNG peripheral.
+static struct {
+    uint32_t words[FUTILS_RNG_POOL_WORDS];
+    uint8_t pos; // Next word
+    uint8_t ready; // Bit per half, filled and not used yet
+    uint8_t pending; // Bit per half, refill queued
+    uint32_t bits; // Booleans take a word one bit at a time
+    uint8_t bit_count;
+    uint32_t refills;
+    uint32_t misses; // Draws that found the pool empty and read the RNG directly
+} futils_rng;
+
+/**
+ * @brief       Refill half of the pool, runs in the timer thread.
+ * @param       context  unused
+ * @param       half     the half to refill
+*/
+static void futils_rng_refill(void* context, uint32_t half) {
+    UNUSED(context);
+    // The half is not ready, so no draw reads it while it's written
+    furi_hal_random_fill_buf(
+        (uint8_t*)&futils_rng.words[half * FUTILS_RNG_HALF], FUTILS_RNG_HALF * sizeof(uint32_t));
+    FURI_CRITICAL_ENTER();
+    futils_rng.ready |= 1 << half;
+    futils_rng.pending &= ~(1 << half);
+    futils_rng.refills++;
+    FURI_CRITICAL_EXIT();
+}
+
+/**
+ * @brief       Take a random word from the pool.
+ * @details     Queues the refill of every half that is used up. If the pool is empty, e.g. on the
+ *              first draw, the word comes straight from the RNG.
+ * @return      the random word
+*/
+uint32_t futils_random_u32(void) {
+    uint32_t word = 0;
+    bool hit = false;
+    uint8_t queue = 0;
+    FURI_CRITICAL_ENTER();
+    const uint8_t half = futils_rng.pos / FUTILS_RNG_HALF;
+    if(futils_rng.ready & (1 << half)) {
+        word = futils_rng.words[futils_rng.pos];
+        futils_rng.pos = (futils_rng.pos + 1) % FUTILS_RNG_POOL_WORDS;
+        if(futils_rng.pos % FUTILS_RNG_HALF == 0) {
+            futils_rng.ready &= ~(1 << half);
+        }
+        hit = true;
+    } else {
+        futils_rng.misses++;
+    }
+    queue = ~(futils_rng.ready | futils_rng.pending) & 0b11;
+    futils_rng.pending |= queue;
+    FURI_CRITICAL_EXIT();
+
+    for(uint8_t h = 0; h < 2; h++) {
+        if(queue & (1 << h)) {
+            furi_timer_pending_callback(futils_rng_refill, NULL, h);
+        }
+    }
+    return hit ? word : furi_hal_random_get();
+}
+
+static void futils_rng_drained(void* context, uint32_t arg) {
+    UNUSED(arg);
+    furi_semaphore_release(context);
+}
+
+/**
+ * @brief       Wait for the refills queued to the timer thread.
+ * @details     They run code and write data of the app image, so the app must not exit before
+ *              they are done. The timer thread runs the pending callbacks in order, the one queued
+ *              here runs after every refill. Call it once nothing draws anymore.
+*/
+void futils_random_drain(void) {
+    FuriSemaphore* drained = furi_semaphore_alloc(1, 0);
+    furi_check(furi_timer_pending_callback(futils_rng_drained, drained, 0) == FuriStatusOk);
+    furi_check(furi_semaphore_acquire(drained, FuriWaitForever) == FuriStatusOk);
+    furi_semaphore_free(drained);
+    furi_check(futils_rng.pending == 0);
+}
+
+static uint32_t futils_random_word(void* context) {
+    UNUSED(context);
+    return futils_random_u32();
+}
+
+/**
+ * @brief       Generate an unbiased random number below a bound, from the pool.
+ * @param       bound  the number of possible results, 0 for the whole 32 bit range
+ * @return      the random number, from 0 to bound - 1
+*/
+uint32_t futils_random_below(uint32_t bound) {
+    return random_below(bound, futils_random_word, NULL);
+}
+
 /**
  * @brief       Generate a random number bewteen min and max
  * @param       min  minimum value
@@ -17,25 +119,58 @@ void futils_buzz_vibration(uint32_t ms) {
  * @return      the random number
 */
 uint32_t futils_random_limit(int32_t min, int32_t max) {
-    uint32_t rnd = furi_hal_random_get() % (max + 1 - min) + min;
-    return rnd;
+    return min + futils_random_below((uint32_t)(max - min) + 1);
 }
 
-static uint32_t rnd;
-static size_t i = 0;
 /**
  * @brief       Generate a random boolean value
  * @return      the random value
 */
 bool futils_random_bool() {
-    if(rnd == 0 || i > 31) {
-        i = 0;
-        rnd = furi_hal_random_get();
-    } else {
-        i++;
+    bool bit = false;
+    bool taken = false;
+    FURI_CRITICAL_ENTER();
+    if(futils_rng.bit_count > 0) {
+        bit = futils_rng.bits & 1;
+        futils_rng.bits >>= 1;
+        futils_rng.bit_count--;
+        taken = true;
     }
+    FURI_CRITICAL_EXIT();
+    if(!taken) {
+        const uint32_t word = futils_random_u32();
+        bit = word & 1;
+        FURI_CRITICAL_ENTER();
+        futils_rng.bits = word >> 1;
+        futils_rng.bit_count = 31;
+        FURI_CRITICAL_EXIT();
+    }
+    return bit;
+}
+
+/**
+ * @brief       Fill a buffer with random bytes from the pool
+ * @param       buf   the buffer
+ * @param       size  its size
+*/
+void futils_random_fill(uint8_t* buf, size_t size) {
+    while(size > 0) {
+        const uint32_t word = futils_random_u32();
+        const size_t len = MIN(size, sizeof(word));
+        memcpy(buf, &word, len);
+        buf += len;
+        size -= len;
+    }
+}
 
-    return rnd & (1 << i);
+/**
+ * @brief       Usage of the random pool
+ * @param       refills  filled with the halves refilled from the RNG
+ * @param       misses   filled with the draws that found the pool empty
+*/
+void futils_random_stats(uint32_t* refills, uint32_t* misses) {
+    *refills = futils_rng.refills;
+    *misses = futils_rng.misses;
 }
 
 /**
@@ -53,6 +188,105 @@ void futils_reverse_array_uint8(uint8_t* arr, size_t size) {
         arr[i] = temp[i];
 }
 
+/**
+ * @brief       Print bytes as an hex string, without separators
+ * @param       out  destination, at least 2 * size + 1 chars
+ * @param       arr  the bytes
+ * @param       size  the number of bytes
+*/
+void futils_bytes_to_hex(char* out, const uint8_t* arr, size_t size) {
+    static const char digits[] = "0123456789ABCDEF";
+    for(size_t i = 0; i < size; i++) {
+        out[i * 2] = digits[arr[i] >> 4];
+        out[i * 2 + 1] = digits[arr[i] & 0x0F];
+    }
+    out[size * 2] = '\0';
+}
+
+/**
+ * @brief       Parse an hex string, without separators
+ * @param       str  the string, must have exactly 2 * size hex digits
+ * @param       arr  destination
+ * @param       size  the number of bytes
+ * @return      false if the string is not valid, arr is left untouched
+*/
+bool futils_hex_to_bytes(const char* str, uint8_t* arr, size_t size) {
+    uint8_t temp[size];
+    for(size_t i = 0; i < size * 2; i++) {
+        const char c = str[i];
+        uint8_t nibble;
+        if(c >= '0' && c <= '9') {
+            nibble = c - '0';
+        } else if(c >= 'a' && c <= 'f') {
+            nibble = c - 'a' + 10;
+        } else if(c >= 'A' && c <= 'F') {
+            nibble = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        temp[i / 2] = (i % 2) ? (temp[i / 2] | nibble) : (uint8_t)(nibble << 4);
+    }
+    if(str[size * 2] != '\0') {
+        return false;
+    }
+    memcpy(arr, temp, size);
+    return true;
+}
+
+/**
+ * @brief       Read a text file line by line without loading it whole.
+ * @details     Lines longer than the buffer are skipped, \r is dropped.
+ * @param       path       the file path
+ * @param       line       buffer for the current line
+ * @param       line_size  size of the line buffer
+ * @param       callback   called for every line
+ * @param       context    context for the callback
+ * @return      false if the file could not be opened
+*/
+bool futils_read_lines(
+    const char* path,
+    char* line,
+    size_t line_size,
+    FutilsLineCallback callback,
+    void* context) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    char buffer[64];
+    size_t line_len = 0;
+    bool skip_line = false;
+    bool proceed = true;
+
+    const bool opened = storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING);
+    if(opened) {
+        size_t read;
+        do {
+            read = storage_file_read(file, buffer, sizeof(buffer));
+            for(size_t i = 0; i <= read && proceed; i++) {
+                // A short read is the end of file, flush the last line too
+                const bool eol = i == read ? read < sizeof(buffer) : buffer[i] == '\n';
+                if(eol) {
+                    line[line_len] = '\0';
+                    if(!skip_line) {
+                        proceed = callback(line, context);
+                    }
+                    line_len = 0;
+                    skip_line = false;
+                } else if(i < read && buffer[i] != '\r') {
+                    if(line_len < line_size - 1) {
+                        line[line_len++] = buffer[i];
+                    } else {
+                        skip_line = true;
+                    }
+                }
+            }
+        } while(read == sizeof(buffer) && proceed);
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    return opened;
+}
+
 /**
  * @brief       Initialize a VariableItem
  * @param       item_list       pointer to the VariableItemList
@@ -107,120 +341,166 @@ void futils_draw_header(
 }
 
 /**
- * @brief      Formats the text box json string.
- * @param      formatted_message    char* holding the formatted string, needs to be freed if not used anymore
- * @param      message              The string to format
- * @param      text_box             Pointer to the TextBox object
+ * @brief      Parse JSON into a token array sized to the document.
+ * @param      json        The JSON text
+ * @param      max_tokens  Max tokens accepted
+ * @param      count       Filled with the number of tokens
+ * @return     the tokens, to be freed, NULL if the text is not valid JSON
 */
-void futils_text_box_format_msg(char* formatted_message, const char* message, TextBox* text_box) {
-    if(text_box == NULL) {
-        FURI_LOG_E(FURI_UTILS_TAG, "Invalid pointer to TextBox");
-        return;
+static jsmntok_t* futils_json_tokens(const char* json, uint32_t max_tokens, int* count) {
+    jsmn_parser parser;
+    jsmn_init(&parser);
+    // A first run without tokens only counts them
+    *count = jsmn_parse(&parser, json, strlen(json), NULL, 0);
+    if(*count <= 0 || (uint32_t)*count > max_tokens) {
+        FURI_LOG_E(FURI_UTILS_TAG, "Can't parse JSON: %d tokens", *count);
+        return NULL;
     }
+    jsmntok_t* tokens = ATRACK_MALLOC(sizeof(jsmntok_t) * *count);
+    jsmn_init(&parser);
+    jsmn_parse(&parser, json, strlen(json), tokens, *count);
+    return tokens;
+}
 
-    if(message == NULL) {
-        FURI_LOG_E(FURI_UTILS_TAG, "Invalid pointer to message");
-        return;
+/**
+ * @brief      Pretty print JSON to a write callback, nothing is buffered.
+ * @param      json        The JSON text
+ * @param      max_tokens  Max tokens accepted
+ * @param      width       Wrap values at this column, 0 to never wrap
+ * @param      write       The output callback
+ * @param      context     The callback context
+ * @return     false if the text is not valid JSON
+*/
+bool futils_json_pretty_stream(
+    const char* json,
+    uint32_t max_tokens,
+    uint8_t width,
+    JsonPrettyWrite write,
+    void* context) {
+    int count;
+    jsmntok_t* tokens = futils_json_tokens(json, max_tokens, &count);
+    if(tokens == NULL) {
+        return false;
     }
+    json_pretty_print(json, tokens, count, width, write, context);
+    ATRACK_FREE(tokens);
+    return true;
+}
 
-    text_box_reset(text_box);
-
-    uint32_t message_length = strlen(message); // Length of the message
-    if(message_length > 0) {
-        uint32_t i = 0; // Index tracker
-        uint32_t formatted_index = 0; // Tracker for where we are in the formatted message
-        if(formatted_message) {
-            free(formatted_message);
-            formatted_message = NULL;
-        }
-
-        formatted_message = (char*)malloc((message_length * 5));
-        if(!formatted_message) {
-            FURI_LOG_E(FURI_UTILS_TAG, "Failed to allocate formatted_message buffer");
-            return;
-        }
+static void futils_json_pretty_buffer_write(const char* data, size_t len, void* context) {
+    char** cursor = (char**)context;
+    memcpy(*cursor, data, len);
+    *cursor += len;
+}
 
-        while(i < message_length) {
-            uint32_t max_line_length = 31; // Maximum characters per line
-            uint32_t remaining_length = message_length - i; // Remaining characters
-            uint32_t line_length = (remaining_length < max_line_length) ? remaining_length :
-                                                                          max_line_length;
-
-            // Check for newline character within the current segment
-            uint32_t newline_pos = i;
-            bool found_newline = false;
-            for(; newline_pos < i + line_length && newline_pos < message_length; newline_pos++) {
-                if(message[newline_pos] == '\n') {
-                    found_newline = true;
-                    break;
-                }
-            }
+/**
+ * @brief      Pretty print JSON into a buffer of the exact size.
+ * @details    The first pass only measures the output, the second one fills the buffer.
+ * @param      json        The JSON text
+ * @param      max_tokens  Max tokens accepted
+ * @param      width       Wrap values at this column, 0 to never wrap
+ * @return     the null terminated text, to be freed, NULL if the text is not valid JSON
+*/
+char* futils_json_pretty(const char* json, uint32_t max_tokens, uint8_t width) {
+    int count;
+    jsmntok_t* tokens = futils_json_tokens(json, max_tokens, &count);
+    if(tokens == NULL) {
+        return NULL;
+    }
+    const size_t size = json_pretty_print(json, tokens, count, width, NULL, NULL);
+    char* text = ATRACK_MALLOC(size + 1);
+    char* cursor = text;
+    json_pretty_print(json, tokens, count, width, futils_json_pretty_buffer_write, &cursor);
+    text[size] = '\0';
+    ATRACK_FREE(tokens);
+    return text;
+}
 
-            if(found_newline) {
-                // If newline found, set line_length up to the newline
-                line_length = newline_pos - i;
-            }
+typedef struct {
+    File* file;
+    char buffer[64];
+    size_t len;
+    bool error;
+} FutilsJsonFileSink;
 
-            // Temporary buffer to hold the current line
-            char line[32];
-            strncpy(line, message + i, line_length);
-            line[line_length] = '\0';
+static void futils_json_file_flush(FutilsJsonFileSink* sink) {
+    if(sink->len && storage_file_write(sink->file, sink->buffer, sink->len) != sink->len) {
+        sink->error = true;
+    }
+    sink->len = 0;
+}
 
-            // Move the index forward by the determined line_length
-            if(!found_newline) {
-                i += line_length;
+static void futils_json_file_write(const char* data, size_t len, void* context) {
+    FutilsJsonFileSink* sink = (FutilsJsonFileSink*)context;
+    while(len > 0) {
+        const size_t chunk = MIN(len, sizeof(sink->buffer) - sink->len);
+        memcpy(sink->buffer + sink->len, data, chunk);
+        sink->len += chunk;
+        data += chunk;
+        len -= chunk;
+        if(sink->len == sizeof(sink->buffer)) {
+            futils_json_file_flush(sink);
+        }
+    }
+}
 
-                // Skip any spaces at the beginning of the next line
-                while(i < message_length && message[i] == ' ') {
-                    i++;
-                }
-            }
-            uint8_t indent_level = 0;
-            // Manually copy the fixed line into the formatted_message buffer, adding newlines where necessary
-            for(uint32_t j = 0; j < line_length; j++) {
-                switch(line[j]) {
-                case '{':
-                    formatted_message[formatted_index++] = line[j];
-                    formatted_message[formatted_index++] = '\n';
-                    indent_level++;
-                    for(size_t k = 0; k < indent_level; k++) {
-                        formatted_message[formatted_index++] = ' ';
-                    }
+/**
+ * @brief      Pretty print JSON to a file, written in small blocks.
+ * @param      json        The JSON text
+ * @param      max_tokens  Max tokens accepted
+ * @param      width       Wrap values at this column, 0 keeps the output valid JSON
+ * @param      path        The file path, overwritten
+ * @return     true if the whole text was written
+*/
+bool futils_json_pretty_to_file(
+    const char* json,
+    uint32_t max_tokens,
+    uint8_t width,
+    const char* path) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    FutilsJsonFileSink sink = {.file = storage_file_alloc(storage)};
+    bool success = false;
+    if(storage_file_open(sink.file, path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        success = futils_json_pretty_stream(
+            json, max_tokens, width, futils_json_file_write, &sink);
+        futils_json_file_flush(&sink);
+        success = success && !sink.error;
+    }
+    storage_file_close(sink.file);
+    storage_file_free(sink.file);
+    furi_record_close(RECORD_STORAGE);
+    return success;
+}
 
-                    break;
-                case ',':
-                    formatted_message[formatted_index++] = line[j];
-                    formatted_message[formatted_index++] = '\n';
-                    for(size_t k = 0; k < indent_level; k++) {
-                        formatted_message[formatted_index++] = ' ';
-                    }
-                    break;
-                case '}':
-                    formatted_message[formatted_index++] = '\n';
-                    for(size_t k = 1; k < indent_level; k++) {
-                        formatted_message[formatted_index++] = ' ';
-                    }
-                    indent_level--;
-                    formatted_message[formatted_index++] = line[j];
-                    break;
-                case '\"':
-                    break;
-                default:
-                    formatted_message[formatted_index++] = line[j];
-                    break;
-                }
-            }
-        }
+/**
+ * @brief      Show a JSON string in a TextBox, pretty printed.
+ * @details    Text that is not valid JSON is shown as it is.
+ * @param      message   The string to format
+ * @param      text_box  Pointer to the TextBox object
+ * @return     the formatted text shown by the TextBox, free it after the TextBox is reset or freed
+*/
+char* futils_text_box_format_msg(const char* message, TextBox* text_box) {
+    if(text_box == NULL) {
+        FURI_LOG_E(FURI_UTILS_TAG, "Invalid pointer to TextBox");
+        return NULL;
+    }
 
-        // Null-terminate the formatted_message
-        formatted_message[formatted_index] = '\0';
+    if(message == NULL) {
+        FURI_LOG_E(FURI_UTILS_TAG, "Invalid pointer to message");
+        return NULL;
+    }
 
-        // Add the formatted message to the text box
-        text_box_set_text(text_box, formatted_message);
-        text_box_set_focus(text_box, TextBoxFocusStart);
-    } else {
+    text_box_reset(text_box);
+    if(strlen(message) == 0) {
         text_box_set_text(text_box, "No data in payload");
+        return NULL;
     }
+
+    char* formatted_message =
+        futils_json_pretty(message, FUTILS_JSON_MAX_TOKENS, FUTILS_TEXT_BOX_WIDTH);
+    text_box_set_text(text_box, formatted_message ? formatted_message : message);
+    text_box_set_focus(text_box, TextBoxFocusStart);
+    return formatted_message;
 }
 
 #if MEMCCPY
@@ -2,13 +2,39 @@
 #include <furi.h>
 #include <gui/modules/text_box.h>
 #include <gui/modules/variable_item_list.h>
+#include "alloc_tracker.h"
+#include "json_pretty.h"
 
 #define FURI_UTILS_TAG "FURI_UTILS"
 #define MEMCCPY        false
 
+#define FUTILS_JSON_MAX_TOKENS 512
+#define FUTILS_TEXT_BOX_WIDTH  31 // Columns of a TextBox line
+#define FUTILS_RNG_POOL_WORDS  32 // Random pool, two halves refilled in turn
+
+uint32_t futils_random_u32(void);
+uint32_t futils_random_below(uint32_t bound);
 uint32_t futils_random_limit(int32_t min, int32_t max);
 bool futils_random_bool();
+void futils_random_fill(uint8_t* buf, size_t size);
+void futils_random_stats(uint32_t* refills, uint32_t* misses);
+void futils_random_drain(void);
 void futils_reverse_array_uint8(uint8_t* arr, size_t size);
+void futils_bytes_to_hex(char* out, const uint8_t* arr, size_t size);
+bool futils_hex_to_bytes(const char* str, uint8_t* arr, size_t size);
+/**
+ * @brief       Called for every line read by futils_read_lines.
+ * @param       line     null terminated line without the line ending, may be modified
+ * @param       context  the callback context
+ * @return      false to stop reading
+*/
+typedef bool (*FutilsLineCallback)(char* line, void* context);
+bool futils_read_lines(
+    const char* path,
+    char* line,
+    size_t line_size,
+    FutilsLineCallback callback,
+    void* context);
 void futils_buzz_vibration(uint32_t ms);
 VariableItem* futils_variable_item_init(
     VariableItemList* item_list,
@@ -25,7 +51,19 @@ void futils_draw_header(
     const int8_t curr_page,
     const int32_t y_pos);
 
-void futils_text_box_format_msg(char* formatted_message, const char* message, TextBox* text_box);
+bool futils_json_pretty_stream(
+    const char* json,
+    uint32_t max_tokens,
+    uint8_t width,
+    JsonPrettyWrite write,
+    void* context);
+char* futils_json_pretty(const char* json, uint32_t max_tokens, uint8_t width);
+bool futils_json_pretty_to_file(
+    const char* json,
+    uint32_t max_tokens,
+    uint8_t width,
+    const char* path);
+char* futils_text_box_format_msg(const char* message, TextBox* text_box);
 void futils_copy_str(
     char* dest,
     const char* src,
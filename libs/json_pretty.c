@@ -0,0 +1,148 @@
+#include "json_pretty.h"
+
+typedef struct {
+    const char* json;
+    const jsmntok_t* tokens;
+    int count;
+    uint8_t width; // Wrap values at this column, 0 never wraps
+    JsonPrettyWrite write; // NULL only counts
+    void* context;
+    size_t size;
+    size_t column;
+} JsonPretty;
+
+static const char json_pretty_spaces[] = "                                ";
+
+static void json_pretty_emit(JsonPretty* pretty, const char* data, size_t len) {
+    if(pretty->write) {
+        pretty->write(data, len, pretty->context);
+    }
+    pretty->size += len;
+    pretty->column += len;
+}
+
+static void json_pretty_newline(JsonPretty* pretty, size_t depth) {
+    json_pretty_emit(pretty, "\n", 1);
+    pretty->column = 0;
+    size_t spaces = depth * JSON_PRETTY_INDENT;
+    while(spaces > 0) {
+        const size_t len = spaces < sizeof(json_pretty_spaces) - 1 ? spaces :
+                                                                   sizeof(json_pretty_spaces) - 1;
+        json_pretty_emit(pretty, json_pretty_spaces, len);
+        spaces -= len;
+    }
+}
+
+/**
+ * @brief      Write text, wrapped at the width with the continuation one level deeper.
+*/
+static void json_pretty_text(JsonPretty* pretty, const char* text, size_t len, size_t depth) {
+    const size_t indent = (depth + 1) * JSON_PRETTY_INDENT;
+    // Wrapping needs room for at least one character after the continuation indent
+    while(pretty->width > indent && pretty->column + len > pretty->width) {
+        if(pretty->column < pretty->width) {
+            const size_t room = pretty->width - pretty->column;
+            json_pretty_emit(pretty, text, room);
+            text += room;
+            len -= room;
+        }
+        json_pretty_newline(pretty, depth + 1);
+    }
+    json_pretty_emit(pretty, text, len);
+}
+
+static void json_pretty_scalar(JsonPretty* pretty, const jsmntok_t* tok, size_t depth) {
+    const char* text = pretty->json + tok->start;
+    const size_t len = tok->end - tok->start;
+    if(tok->type == JSMN_STRING) {
+        // The token excludes the quotes, escapes are kept as they are
+        json_pretty_text(pretty, "\"", 1, depth);
+        json_pretty_text(pretty, text, len, depth);
+        json_pretty_text(pretty, "\"", 1, depth);
+    } else {
+        json_pretty_text(pretty, text, len, depth);
+    }
+}
+
+/**
+ * @brief      Write a token and its children.
+ * @details    Recurses once per nesting level, down to JSON_PRETTY_MAX_DEPTH.
+ * @return     the index of the token after the subtree
+*/
+static int json_pretty_node(JsonPretty* pretty, int index, size_t depth) {
+    if(index >= pretty->count) {
+        return pretty->count;
+    }
+    const jsmntok_t* tok = &pretty->tokens[index];
+    if(tok->type != JSMN_OBJECT && tok->type != JSMN_ARRAY) {
+        json_pretty_scalar(pretty, tok, depth);
+        return index + 1;
+    }
+
+    if(depth >= JSON_PRETTY_MAX_DEPTH) {
+        // A hand-edited file could nest deep enough to overflow the stack, keep the source text
+        json_pretty_text(pretty, pretty->json + tok->start, tok->end - tok->start, depth);
+        int next = index + 1;
+        while(next < pretty->count && pretty->tokens[next].start < tok->end) {
+            next++;
+        }
+        return next;
+    }
+
+    const bool object = tok->type == JSMN_OBJECT;
+    json_pretty_emit(pretty, object ? "{" : "[", 1);
+    int next = index + 1;
+    for(int i = 0; i < tok->size && next < pretty->count; i++) {
+        if(i > 0) {
+            json_pretty_emit(pretty, ",", 1);
+        }
+        json_pretty_newline(pretty, depth + 1);
+        if(object) {
+            json_pretty_scalar(pretty, &pretty->tokens[next++], depth + 1);
+            json_pretty_emit(pretty, ": ", 2);
+        }
+        next = json_pretty_node(pretty, next, depth + 1);
+    }
+    if(tok->size > 0) {
+        json_pretty_newline(pretty, depth);
+    }
+    json_pretty_emit(pretty, object ? "}" : "]", 1);
+    return next;
+}
+
+/**
+ * @brief      Pretty print parsed JSON.
+ * @details    Run it first without a write callback to get the exact output size.
+ * @param      json     the JSON text the tokens point in
+ * @param      tokens   the jsmn tokens
+ * @param      count    the number of tokens, as returned by jsmn_parse
+ * @param      width    wrap values longer than this many columns, 0 to never wrap
+ * @param      write    the output callback, NULL to only count
+ * @param      context  the callback context
+ * @return     the output length, without a terminator
+*/
+size_t json_pretty_print(
+    const char* json,
+    const jsmntok_t* tokens,
+    int count,
+    uint8_t width,
+    JsonPrettyWrite write,
+    void* context) {
+    JsonPretty pretty = {
+        .json = json,
+        .tokens = tokens,
+        .count = count,
+        .width = width,
+        .write = write,
+        .context = context,
+    };
+    int next = 0;
+    while(next < count) {
+        if(next > 0) {
+            json_pretty_emit(&pretty, "\n", 1);
+            pretty.column = 0;
+        }
+        next = json_pretty_node(&pretty, next, 0);
+    }
+    return pretty.size;
+}
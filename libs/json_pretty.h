@@ -0,0 +1,29 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "jsmn_parser.h"
+
+// Pretty printer walking the jsmn tokens, so braces and commas inside strings are left alone.
+// The output goes to a write callback: counting, filling a buffer or streaming to a file.
+// It has no furi dependency so it can be driven from a host build.
+
+#define JSON_PRETTY_INDENT    2
+// Containers nested deeper are written as they are in the source, the walk recurses per level
+#define JSON_PRETTY_MAX_DEPTH 16
+
+/**
+ * @brief      Output callback of the pretty printer.
+ * @param      data     the text to write, not null terminated
+ * @param      len      the text length
+ * @param      context  the callback context
+*/
+typedef void (*JsonPrettyWrite)(const char* data, size_t len, void* context);
+
+size_t json_pretty_print(
+    const char* json,
+    const jsmntok_t* tokens,
+    int count,
+    uint8_t width,
+    JsonPrettyWrite write,
+    void* context);
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+
+// Unbiased reduction of random words to a bound, whatever the source of the words.
+// It has no furi dependency so the distribution can be checked from a host build.
+
+/**
+ * @brief       Source of uniform 32 bit random words.
+ * @param       context  the source context
+ * @return      the next word
+*/
+typedef uint32_t (*RandomWord)(void* context);
+
+/**
+ * @brief       Generate an unbiased random number below a bound.
+ * @details     Multiply and shift, the few products that would favor some results are drawn
+ *              again (Lemire), so it takes a single word almost every time.
+ * @param       bound    the number of possible results, 0 for the whole 32 bit range
+ * @param       word     the source of random words
+ * @param       context  the source context
+ * @return      the random number, from 0 to bound - 1
+*/
+static inline uint32_t random_below(uint32_t bound, RandomWord word, void* context) {
+    if(bound == 0) {
+        return word(context);
+    }
+    uint64_t product = (uint64_t)word(context) * bound;
+    if((uint32_t)product < bound) {
+        const uint32_t threshold = -bound % bound;
+        while((uint32_t)product < threshold) {
+            product = (uint64_t)word(context) * bound;
+        }
+    }
+    return product >> 32;
+}
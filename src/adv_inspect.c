@@ -0,0 +1,261 @@
+#include "adv_inspect.h"
+#include "bthome.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char* const adv_inspect_event_names[] = {
+    "none",
+    "short",
+    "double",
+    "triple",
+    "long",
+    "long dbl",
+    "long trpl",
+};
+
+static const char* const adv_inspect_dimmer_names[] = {"none", "left", "right"};
+
+static void adv_inspect_line(AdvInspect* inspect, const char* format, ...) {
+    if(inspect->line_count == ADV_INSPECT_LINES) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    vsnprintf(inspect->lines[inspect->line_count++], ADV_INSPECT_COLS + 1, format, args);
+    va_end(args);
+}
+
+static uint32_t adv_inspect_le(const uint8_t* data, uint8_t len) {
+    uint32_t value = 0;
+    for(uint8_t i = len; i > 0; i--) {
+        value = value << 8 | data[i - 1];
+    }
+    return value;
+}
+
+/**
+ * @brief      Size of the value of a BTHome object, 0 if the id is not known.
+*/
+static uint8_t adv_inspect_object_size(uint8_t id) {
+    switch(id) {
+    case BTHOME_OBJ_PACKET_ID:
+    case BTHOME_OBJ_BATTERY:
+    case BTHOME_OBJ_BUTTON:
+        return 1;
+    case BTHOME_OBJ_TEMPERATURE:
+    case BTHOME_OBJ_VOLTAGE:
+    case BTHOME_OBJ_DIMMER:
+        return 2;
+    case BTHOME_OBJ_COUNT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+static void adv_inspect_object(AdvInspect* inspect, uint8_t id, const uint8_t* value) {
+    const uint32_t raw = adv_inspect_le(value, adv_inspect_object_size(id));
+    switch(id) {
+    case BTHOME_OBJ_PACKET_ID:
+        adv_inspect_line(inspect, " %02X packet id %lu", id, raw);
+        break;
+    case BTHOME_OBJ_BATTERY:
+        adv_inspect_line(inspect, " %02X battery %lu%%", id, raw);
+        break;
+    case BTHOME_OBJ_TEMPERATURE: {
+        const int16_t temp = (int16_t)raw;
+        const uint16_t abs_temp = temp < 0 ? -temp : temp;
+        adv_inspect_line(
+            inspect,
+            " %02X temp %s%u.%02uC",
+            id,
+            temp < 0 ? "-" : "",
+            abs_temp / 100,
+            abs_temp % 100);
+        break;
+    }
+    case BTHOME_OBJ_VOLTAGE:
+        adv_inspect_line(inspect, " %02X volt %lu.%03luV", id, raw / 1000, raw % 1000);
+        break;
+    case BTHOME_OBJ_COUNT:
+        adv_inspect_line(inspect, " %02X count %lu", id, raw);
+        break;
+    case BTHOME_OBJ_BUTTON:
+        adv_inspect_line(
+            inspect,
+            " %02X button %s",
+            id,
+            raw <= BTHomeLongTriplePress ? adv_inspect_event_names[raw] : "?");
+        break;
+    case BTHOME_OBJ_DIMMER:
+        adv_inspect_line(
+            inspect,
+            " %02X dim %s %u",
+            id,
+            value[0] <= BTHomeDimmerRotateRight ? adv_inspect_dimmer_names[value[0]] : "?",
+            value[1]);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief      Decode the BTHome objects of a service data structure.
+ * @param      data  The service data after the UUID, starting with the device info byte.
+ * @param      len   Its length.
+*/
+static void adv_inspect_bthome(AdvInspect* inspect, const uint8_t* data, uint8_t len) {
+    if(len == 0) {
+        inspect->malformed = true;
+        return;
+    }
+    const uint8_t info = data[0];
+    const bool encrypted = info & 0x01;
+    adv_inspect_line(
+        inspect,
+        " BTHome v%u%s%s",
+        info >> 5,
+        encrypted ? " enc" : "",
+        info & 0x04 ? " trigger" : "");
+    if(encrypted) {
+        return;
+    }
+    uint8_t i = 1;
+    while(i < len) {
+        const uint8_t id = data[i++];
+        const uint8_t size = adv_inspect_object_size(id);
+        if(size == 0 || i + size > len) {
+            // The size of an unknown object is unknown too, the rest can't be decoded
+            adv_inspect_line(inspect, " %02X ? %u bytes left", id, len - i);
+            inspect->malformed = size != 0;
+            return;
+        }
+        if(id == BTHOME_OBJ_PACKET_ID) {
+            inspect->id_pos = &data[i] - inspect->data;
+            inspect->id_line = inspect->line_count;
+        }
+        adv_inspect_object(inspect, id, &data[i]);
+        inspect->obj_count++;
+        i += size;
+    }
+}
+
+static void adv_inspect_ad(AdvInspect* inspect, uint8_t type, const uint8_t* data, uint8_t len) {
+    switch(type) {
+    case 0x01:
+        adv_inspect_line(inspect, "%02X flags %02X", type, len ? data[0] : 0);
+        break;
+    case 0x08:
+    case 0x09:
+        adv_inspect_line(
+            inspect,
+            "%02X %s %.*s",
+            type,
+            type == 0x08 ? "short" : "name",
+            len,
+            (const char*)data);
+        break;
+    case 0x16:
+        if(len >= 2 && data[0] == BTHOME_UUID_LO && data[1] == BTHOME_UUID_HI) {
+            adv_inspect_line(inspect, "%02X service %02X%02X", type, data[1], data[0]);
+            adv_inspect_bthome(inspect, &data[2], len - 2);
+        } else {
+            adv_inspect_line(inspect, "%02X service %u bytes", type, len);
+        }
+        break;
+    default:
+        adv_inspect_line(inspect, "%02X %u bytes", type, len);
+        break;
+    }
+}
+
+/**
+ * @brief      Whether data is the decoded advertisement, its packet id aside.
+*/
+static bool adv_inspect_same(const AdvInspect* inspect, const uint8_t* data, uint8_t size) {
+    const uint8_t pos = inspect->id_pos;
+    if(size != inspect->size) {
+        return false;
+    }
+    if(pos == 0) {
+        return memcmp(data, inspect->data, size) == 0;
+    }
+    return memcmp(data, inspect->data, pos) == 0 &&
+           memcmp(&data[pos + 1], &inspect->data[pos + 1], size - pos - 1) == 0;
+}
+
+/**
+ * @brief      Write a new packet id in the data, its hex dump and its object line.
+*/
+static void adv_inspect_patch_id(AdvInspect* inspect, uint8_t id) {
+    const uint8_t pos = inspect->id_pos;
+    char* hex = &inspect->lines[pos / ADV_INSPECT_HEX_BYTES][(pos % ADV_INSPECT_HEX_BYTES) * 2];
+    char text[3];
+    inspect->data[pos] = id;
+    // Two digits in place, the rest of the hex dump line is kept
+    snprintf(text, sizeof(text), "%02X", id);
+    memcpy(hex, text, 2);
+    if(inspect->id_line < inspect->line_count) {
+        const uint8_t line_count = inspect->line_count;
+        inspect->line_count = inspect->id_line;
+        adv_inspect_object(inspect, BTHOME_OBJ_PACKET_ID, &inspect->data[pos]);
+        inspect->line_count = line_count;
+    }
+    inspect->id_updates++;
+}
+
+/**
+ * @brief      Decode an advertisement, unless it's the one already decoded.
+ * @details    When only the packet id differs, it's patched in the text instead.
+ * @param      inspect  The AdvInspect object.
+ * @param      data     The advertising data.
+ * @param      size     Its size, at most ADV_INSPECT_DATA_SIZE.
+ * @return     true if the text was rebuilt
+*/
+bool adv_inspect_update(AdvInspect* inspect, const uint8_t* data, uint8_t size) {
+    if(size > ADV_INSPECT_DATA_SIZE) {
+        size = ADV_INSPECT_DATA_SIZE;
+    }
+    if(adv_inspect_same(inspect, data, size)) {
+        if(inspect->id_pos && data[inspect->id_pos] != inspect->data[inspect->id_pos]) {
+            adv_inspect_patch_id(inspect, data[inspect->id_pos]);
+        }
+        return false;
+    }
+    memcpy(inspect->data, data, size);
+    // Decoded from the copy, so the object offsets are offsets in inspect->data
+    data = inspect->data;
+    inspect->size = size;
+    inspect->line_count = 0;
+    inspect->ad_count = 0;
+    inspect->obj_count = 0;
+    inspect->malformed = false;
+    inspect->id_pos = 0;
+    inspect->decodes++;
+
+    for(uint8_t i = 0; i < size; i += ADV_INSPECT_HEX_BYTES) {
+        char* line = inspect->lines[inspect->line_count++];
+        for(uint8_t j = i; j < size && j < i + ADV_INSPECT_HEX_BYTES; j++) {
+            snprintf(&line[(j - i) * 2], 3, "%02X", data[j]);
+        }
+    }
+    uint8_t i = 0;
+    while(i < size) {
+        const uint8_t len = data[i];
+        if(len == 0) {
+            // Zero length means the significant part is over
+            break;
+        }
+        if(i + 1 + len > size) {
+            adv_inspect_line(inspect, "bad length at %u", i);
+            inspect->malformed = true;
+            break;
+        }
+        adv_inspect_ad(inspect, data[i + 1], &data[i + 2], len - 1);
+        inspect->ad_count++;
+        i += 1 + len;
+    }
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+// Decoded view of the advertisement on air: hex dump, AD structures and BTHome objects.
+// It has no furi dependency, the text is built once per packet and then only read. A new packet
+// id alone is patched in, every button press changes it.
+
+#define ADV_INSPECT_DATA_SIZE 31 // Legacy advertising data
+#define ADV_INSPECT_COLS      20 // Fits the screen in FontKeyboard
+#define ADV_INSPECT_LINES     20
+#define ADV_INSPECT_HEX_BYTES 10 // Per hex dump line
+
+typedef struct {
+    uint8_t data[ADV_INSPECT_DATA_SIZE];
+    uint8_t size; // 0 before the first packet
+    char lines[ADV_INSPECT_LINES][ADV_INSPECT_COLS + 1];
+    uint8_t line_count;
+    uint8_t ad_count; // AD structures
+    uint8_t obj_count; // BTHome objects
+    bool malformed;
+    uint8_t id_pos; // Offset of the packet id value, 0 if there is none
+    uint8_t id_line; // Line of the packet id object
+    uint32_t decodes; // Packets decoded, repeated data is not
+    uint32_t id_updates; // Packets that only changed the packet id
+} AdvInspect;
+
+bool adv_inspect_update(AdvInspect* inspect, const uint8_t* data, uint8_t size);
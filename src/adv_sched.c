@@ -0,0 +1,183 @@
+#include "adv_sched.h"
+
+static uint32_t adv_sched_min(uint32_t a, uint32_t b) {
+    return a < b ? a : b;
+}
+
+/**
+ * @brief      Advertising interval of a schedule step.
+ * @param      config  The AdvSchedConfig.
+ * @param      step    The step index, 0 is the burst.
+ * @return     the interval in ms
+*/
+uint32_t adv_sched_interval(const AdvSchedConfig* config, uint8_t step) {
+    return adv_sched_min((uint32_t)config->period_ms << step, ADAPTIVE_MAX_INTERVAL);
+}
+
+/**
+ * @brief      Whether the adaptive schedule applies, a send count always uses a single burst.
+*/
+bool adv_sched_is_adaptive(const AdvSchedConfig* config) {
+    return config->adaptive && config->send_count == 0;
+}
+
+/**
+ * @brief      Window an event stays on air.
+ * @details    With a send count the window covers that many events at the slowest interval
+ *             the controller may pick, so no event is cut short.
+ * @param      config           The AdvSchedConfig.
+ * @param      max_interval_ms  The max of the interval range of the burst.
+ * @return     the window in ms
+*/
+uint32_t adv_sched_window_ms(const AdvSchedConfig* config, uint32_t max_interval_ms) {
+    return config->send_count ? config->send_count * (max_interval_ms + ADV_DELAY_MAX) :
+                                config->duration_ms;
+}
+
+/**
+ * @brief      Set the interval range, the controller picks in [min, 1.5 min].
+ * @details    Both are kept within the HAL limit, which would otherwise fail the furi_check of
+ *             the config.
+*/
+static void adv_sched_set_interval(AdvSched* sched, const AdvSchedHal* hal, uint32_t interval) {
+    const uint32_t min_interval = adv_sched_min(interval, ADV_INTERVAL_MAX * 2 / 3);
+    sched->min_interval_ms = min_interval;
+    sched->max_interval_ms = min_interval * 3 / 2;
+    hal->set_interval(sched->min_interval_ms, sched->max_interval_ms, hal->context);
+}
+
+/**
+ * @brief      Largest window the jitter can draw, e.g. to size a simulated timeline.
+ * @param      config  The AdvSchedConfig.
+ * @return     the window in ms
+*/
+uint32_t adv_sched_max_window_ms(const AdvSchedConfig* config) {
+    const uint32_t interval = config->period_ms + config->period_ms * config->interval_pct / 100;
+    return adv_sched_window_ms(config, adv_sched_min(interval, ADV_INTERVAL_MAX * 2 / 3) * 3 / 2);
+}
+
+/**
+ * @brief      Advertising interval with the random increase of the jitter setting.
+ * @details    Remotes that share the same interval would otherwise keep colliding once their
+ *             events line up. Drawn again for every step.
+ * @return     the min interval in ms
+*/
+static uint32_t adv_sched_jitter_interval(
+    const AdvSchedConfig* config,
+    const AdvSchedHal* hal,
+    uint32_t interval) {
+    const uint32_t spread = interval * config->interval_pct / 100;
+    return interval + hal->random_below(spread + 1, hal->context);
+}
+
+/**
+ * @brief      Length of a schedule step, the fixed schedule has a single step.
+ * @param      config   The AdvSchedConfig.
+ * @param      sched    The AdvSched, for its window.
+ * @param      step     The step index.
+ * @param      elapsed  ms of the schedule before the step.
+ * @return     the step length in ms, clipped to the end of the window
+*/
+uint32_t adv_sched_step_ms(
+    const AdvSchedConfig* config,
+    const AdvSched* sched,
+    uint8_t step,
+    uint32_t elapsed) {
+    const uint32_t step_ms = adv_sched_is_adaptive(config) ?
+                                 adv_sched_interval(config, step) * ADAPTIVE_EVENTS_PER_STEP :
+                                 sched->window_ms;
+    return adv_sched_min(step_ms, sched->window_ms - elapsed);
+}
+
+/**
+ * @brief      Number of advertising events the schedule sends in its window.
+ * @param      config  The AdvSchedConfig.
+ * @param      sched   The AdvSched, for its window.
+ * @return     the advertising events count
+*/
+uint32_t adv_sched_adv_events(const AdvSchedConfig* config, const AdvSched* sched) {
+    if(config->send_count) {
+        return config->send_count;
+    }
+    uint32_t events = 0;
+    uint32_t elapsed = 0;
+    for(uint8_t step = 0; elapsed < sched->window_ms; step++) {
+        const uint32_t step_ms = adv_sched_step_ms(config, sched, step, elapsed);
+        events += step_ms / adv_sched_interval(config, step);
+        elapsed += step_ms;
+    }
+    return events;
+}
+
+/**
+ * @brief      Begin the schedule of a new event: the burst interval and the window.
+ * @details    Also computes the airtime saved against the fixed schedule. The beacon is
+ *             configured and its data set by the caller before adv_sched_start().
+ * @param      sched        The AdvSched.
+ * @param      config       The AdvSchedConfig.
+ * @param      hal          The clock and radio.
+ * @param      reconfigure  false keeps the interval of the beacon on air, only the data changes.
+*/
+void adv_sched_begin(
+    AdvSched* sched,
+    const AdvSchedConfig* config,
+    const AdvSchedHal* hal,
+    bool reconfigure) {
+    if(reconfigure) {
+        adv_sched_set_interval(
+            sched, hal, adv_sched_jitter_interval(config, hal, config->period_ms));
+    }
+    sched->window_ms = adv_sched_window_ms(config, sched->max_interval_ms);
+    sched->step = 0;
+    sched->elapsed_ms = adv_sched_step_ms(config, sched, 0, 0);
+
+    const uint32_t fixed_events = config->duration_ms / config->period_ms;
+    const uint32_t events = adv_sched_adv_events(config, sched);
+    sched->airtime_saved_pct = fixed_events > events ? 100 - events * 100 / fixed_events : 0;
+}
+
+/**
+ * @brief      Start the configured beacon after the random start offset of the jitter setting.
+ * @details    Remotes triggered together, e.g. by the same automation, start apart. The first
+ *             step is timed from the start.
+ * @param      sched   The AdvSched.
+ * @param      config  The AdvSchedConfig.
+ * @param      hal     The clock and radio.
+ * @param      start   false if the beacon is already on air.
+*/
+void adv_sched_start(
+    AdvSched* sched,
+    const AdvSchedConfig* config,
+    const AdvSchedHal* hal,
+    bool start) {
+    uint32_t offset_ms = 0;
+    if(start) {
+        sched->offset_ms =
+            config->offset_ms ? hal->random_below(config->offset_ms + 1, hal->context) : 0;
+        offset_ms = sched->offset_ms;
+        hal->start(offset_ms, hal->context);
+    }
+    hal->timer(offset_ms + sched->elapsed_ms, hal->context);
+}
+
+/**
+ * @brief      Move to the next step of the adaptive schedule.
+ * @details    Only the advertising interval changes, with a new jitter draw.
+ * @param      sched   The AdvSched.
+ * @param      config  The AdvSchedConfig.
+ * @param      hal     The clock and radio.
+ * @return     false if the schedule is over
+*/
+bool adv_sched_next(AdvSched* sched, const AdvSchedConfig* config, const AdvSchedHal* hal) {
+    if(!adv_sched_is_adaptive(config) || sched->elapsed_ms >= sched->window_ms) {
+        sched->step = 0;
+        return false;
+    }
+    const uint8_t step = ++sched->step;
+    const uint32_t step_ms = adv_sched_step_ms(config, sched, step, sched->elapsed_ms);
+    sched->elapsed_ms += step_ms;
+    adv_sched_set_interval(
+        sched, hal, adv_sched_jitter_interval(config, hal, adv_sched_interval(config, step)));
+    hal->timer(step_ms, hal->context);
+    return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+// Advertising schedule of an event: the burst, the adaptive steps, the jitter and the window.
+// The decisions are taken here, the clock and the radio are behind AdvSchedHal: the comm worker
+// passes the extra beacon HAL and the furi timers, the fleet simulation a modeled radio on a
+// virtual clock. It has no furi dependency so it can be driven from a host build.
+
+// Adaptive schedule: burst at the period, then double the interval every step
+#define ADAPTIVE_EVENTS_PER_STEP 10U
+#define ADAPTIVE_MAX_INTERVAL    640U
+// Max pseudo-random delay the controller adds to every advertising event (ms)
+#define ADV_DELAY_MAX            10U
+// Max advertising interval the HAL accepts (ms)
+#define ADV_INTERVAL_MAX         10240U
+
+typedef struct {
+    uint16_t period_ms; // Interval of the burst
+    uint16_t duration_ms; // Window without a send count
+    uint8_t send_count; // Advertising events per event, 0 uses duration_ms
+    bool adaptive; // Slow down step by step, only without a send count
+    uint8_t offset_ms; // Max random delay before the beacon starts
+    uint8_t interval_pct; // Max random increase of the advertising interval
+} AdvSchedConfig;
+
+typedef struct {
+    // Unbiased random number below bound
+    uint32_t (*random_below)(uint32_t bound, void* context);
+    // Set the interval range of the beacon config, a beacon on air is restarted with it
+    void (*set_interval)(uint32_t min_ms, uint32_t max_ms, void* context);
+    // Start the configured beacon delay_ms from now
+    void (*start)(uint32_t delay_ms, void* context);
+    // Call adv_sched_next() ms from now
+    void (*timer)(uint32_t ms, void* context);
+    void* context;
+} AdvSchedHal;
+
+typedef struct {
+    uint32_t window_ms; // The current event stays on air this long
+    uint32_t elapsed_ms; // Of the schedule, up to the end of the current step
+    uint8_t step; // 0 is the burst
+    uint16_t min_interval_ms; // Range set for the controller
+    uint16_t max_interval_ms;
+    uint8_t offset_ms; // Drawn for the last event
+    uint8_t airtime_saved_pct; // Of the last event, against the fixed schedule
+} AdvSched;
+
+uint32_t adv_sched_interval(const AdvSchedConfig* config, uint8_t step);
+bool adv_sched_is_adaptive(const AdvSchedConfig* config);
+uint32_t adv_sched_window_ms(const AdvSchedConfig* config, uint32_t max_interval_ms);
+uint32_t adv_sched_max_window_ms(const AdvSchedConfig* config);
+uint32_t adv_sched_step_ms(
+    const AdvSchedConfig* config,
+    const AdvSched* sched,
+    uint8_t step,
+    uint32_t elapsed);
+uint32_t adv_sched_adv_events(const AdvSchedConfig* config, const AdvSched* sched);
+void adv_sched_begin(
+    AdvSched* sched,
+    const AdvSchedConfig* config,
+    const AdvSchedHal* hal,
+    bool reconfigure);
+void adv_sched_start(
+    AdvSched* sched,
+    const AdvSchedConfig* config,
+    const AdvSchedHal* hal,
+    bool start);
+bool adv_sched_next(AdvSched* sched, const AdvSchedConfig* config, const AdvSchedHal* hal);
@@ -1,18 +1,55 @@
 #include "app.h"
 #include "alloc_free.h"
 #include "bt.h"
+#include "bt_cli.h"
+#include "heap_stats.h"
+#include "subghz_view.h"
+#include "tx_log_view.h"
 #include "libs/furi_utils.h"
 
 static const char* DEVICE_NAME_LABEL = "Device Name";
+static const char* NAME_POLICY_LABEL = "Name in Packet";
 static const char* BEACON_PERIOD_LABEL = "Adv. Interval";
 static const char* BEACON_DURATION_LABEL = "Beacon Duration";
-static const char* RANDOMIZE_MAC_LABEL = "Randomize MAC";
+static const char* ADV_SCHEDULE_LABEL = "Adv. Schedule";
+static const char* SEND_COUNT_LABEL = "Send Count";
+static const char* ADV_JITTER_LABEL = "Adv. Jitter";
+static const char* PROFILE_LABEL = "Profile";
+static const char* TX_POWER_LABEL = "TX Power";
+static const char* CHANNELS_LABEL = "Adv. Channels";
+static const char* MAC_MODE_LABEL = "MAC Mode";
+static const char* RPA_ROTATION_LABEL = "RPA Rotation";
+static const char* CUSTOM_MAC_LABEL = "Custom MAC";
+static const char* REMOTE_MODE_LABEL = "Remote Mode";
+static const char* MULTI_PRESS_LABEL = "Multi Press";
+static const char* LONG_PRESS_LABEL = "Long Press";
+static const char* HOLD_TO_DIM_LABEL = "Hold To Dim";
+static const char* SENSOR_MODE_LABEL = "Sensor Mode";
+static const char* UART_BRIDGE_LABEL = "UART Bridge";
+static const char* SUBGHZ_MIRROR_LABEL = "Sub-GHz Mirror";
+static const char* COEX_LABEL = "Keep Other Beacon";
 
 extern const uint16_t beacon_period_values[4];
 extern const char* beacon_period_names[4];
 extern uint16_t beacon_duration_values[4];
 extern char* beacon_duration_names[4];
-extern const char* randomize_mac_names[2];
+extern const char* adv_schedule_names[2];
+extern const char* send_count_names[5];
+extern const char* adv_jitter_names[4];
+extern const char* profile_names[PROFILE_COUNT];
+extern const char* tx_power_names[6];
+extern const char* channels_names[4];
+extern const char* mac_mode_names[4];
+extern const char* rpa_rotation_names[3];
+extern const char* remote_mode_names[2];
+extern const char* multi_press_names[4];
+extern const char* long_press_names[3];
+extern const char* hold_to_dim_names[2];
+extern const char* sensor_mode_names[3];
+extern const char* uart_bridge_names[2];
+extern const char* subghz_mirror_names[2];
+extern const char* coex_names[2];
+extern const char* name_policy_names[NAME_POLICY_COUNT];
 
 /**
  * @brief      Allocate the application.
@@ -20,7 +57,7 @@ extern const char* randomize_mac_names[2];
  * @return     App object.
 */
 App* app_alloc() {
-    App* app = malloc(sizeof(App));
+    App* app = ATRACK_MALLOC(sizeof(App));
 
     Gui* gui = furi_record_open(RECORD_GUI);
 
@@ -33,7 +70,13 @@ App* app_alloc() {
     submenu_set_header(app->submenu, "BT Home Remote");
     submenu_add_item(app->submenu, "Config", SubmenuIndexConfigure, submenu_callback, app);
     submenu_add_item(app->submenu, "BT Home Remote", SubmenuIndexBT, submenu_callback, app);
+    submenu_add_item(app->submenu, "Sub-GHz Mirror", SubmenuIndexSghz, submenu_callback, app);
+    submenu_add_item(app->submenu, "TX Log", SubmenuIndexTxLog, submenu_callback, app);
+    submenu_add_item(app->submenu, "Config File", SubmenuIndexConfigFile, submenu_callback, app);
     submenu_add_item(app->submenu, "About", SubmenuIndexAbout, submenu_callback, app);
+#if ALLOC_TRACKER
+    submenu_add_item(app->submenu, "Heap Stats", SubmenuIndexHeapStats, submenu_callback, app);
+#endif
     submenu_set_selected_item(app->submenu, SubmenuIndexBT);
     view_set_previous_callback(submenu_get_view(app->submenu), navigation_exit_callback);
     view_dispatcher_add_view(app->view_dispatcher, ViewSubmenu, submenu_get_view(app->submenu));
@@ -49,15 +92,21 @@ App* app_alloc() {
     view_set_custom_callback(app->view_bt, view_custom_event_callback);
     view_allocate_model(app->view_bt, ViewModelTypeLockFree, sizeof(BtBeacon));
     app->temp_device_name_size = MAX_NAME_LENGHT + 1;
-    app->temp_device_name = malloc(app->temp_device_name_size + 1);
+    app->temp_device_name = ATRACK_MALLOC(app->temp_device_name_size + 1);
     app->text_input_device_name = text_input_alloc();
     view_dispatcher_add_view(
         app->view_dispatcher,
         ViewTextInputDeviceName,
         text_input_get_view(app->text_input_device_name));
+    app->text_input_custom_mac = uart_text_input_alloc();
+    view_dispatcher_add_view(
+        app->view_dispatcher,
+        ViewTextInputCustomMac,
+        uart_text_input_get_view(app->text_input_custom_mac));
     BtBeacon* bt_model = view_get_model(app->view_bt);
     bt_model->last_input = INPUT_RESET;
     bt_model->mac_address_str = furi_string_alloc();
+    bt_model->custom_mac_str = furi_string_alloc();
     bt_model->cnt = 0;
     bt_model->worker_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
     bt_model->config.adv_channel_map = GapAdvChannelMapAll;
@@ -65,7 +114,7 @@ App* app_alloc() {
     bt_model->config.address_type = GapAddressTypePublic;
     bt_model->default_name_len = strlen(furi_hal_version_get_device_name_ptr());
     bt_model->default_device_name = furi_hal_version_get_device_name_ptr();
-    bt_model->device_name = malloc(MAX_NAME_LENGHT + 1);
+    bt_model->device_name = ATRACK_MALLOC(MAX_NAME_LENGHT + 1);
     futils_copy_str(
         bt_model->device_name,
         bt_model->default_device_name,
@@ -76,6 +125,7 @@ App* app_alloc() {
     bt_model->device_name[bt_model->default_name_len] = '\0';
     bt_model->device_name_len = strlen(bt_model->default_device_name) + 1;
     bt_model->curr_page = PageFirst;
+    bt_model->inspect_top = 0;
     FURI_LOG_I(
         BT_TAG, "Device Name: %s, Size: %u", bt_model->device_name, bt_model->device_name_len);
     const GapExtraBeaconConfig* prev_cfg_ptr = furi_hal_bt_extra_beacon_get_config();
@@ -88,10 +138,52 @@ App* app_alloc() {
 
     bt_model->prev_data_len = furi_hal_bt_extra_beacon_get_data(bt_model->prev_data);
     bt_model->prev_active = furi_hal_bt_extra_beacon_is_active();
+    bt_model->coex.owner = bt_model->prev_active ? CoexOwnerPrev : CoexOwnerNone;
+    bt_model->coex.since = furi_get_tick();
+    if(bt_model->prev_exists) {
+        bt_model->coex.interval_ms = bt_model->prev_config.min_adv_interval_ms;
+        bt_model->coex.data_len = bt_model->prev_data_len;
+        bt_model->coex.channels = __builtin_popcount(bt_model->prev_config.adv_channel_map);
+    }
 
     view_dispatcher_add_view(app->view_dispatcher, ViewBt, app->view_bt);
 
+    // Timers and worker live for the whole app, BT view enter/exit only resume/suspend them
+    bt_model->timer_reset_beacon =
+        furi_timer_alloc(timer_beacon_reset_callback, FuriTimerTypeOnce, app);
+    app->timer_draw = furi_timer_alloc(view_bt_timer_callback, FuriTimerTypePeriodic, app);
+    app->timer_reset_key = furi_timer_alloc(view_timer_key_reset_callback, FuriTimerTypeOnce, app);
+    app->timer_gesture = furi_timer_alloc(bt_gesture_timer_callback, FuriTimerTypeOnce, app);
+    bt_model->timer_dim = furi_timer_alloc(timer_dim_callback, FuriTimerTypeOnce, app);
+    bt_model->timer_sensor = furi_timer_alloc(timer_sensor_callback, FuriTimerTypePeriodic, app);
+    bt_model->timer_rpa = furi_timer_alloc(timer_rpa_callback, FuriTimerTypePeriodic, app);
+    app->cmd_queue = furi_message_queue_alloc(CMD_QUEUE_SIZE, sizeof(Cmd));
+
     load_settings(app);
+    // After load_settings, it creates the folder on the first run
+    bt_model->counter = counter_store_alloc(BT_COUNTER_PATH);
+    bt_model->tx_log = tx_log_alloc(BT_TX_LOG_PATH, BT_TX_LOG_INDEX_PATH);
+    // Static addresses are prepared once here, not on every view enter
+    bt_set_address(bt_model);
+    bt_gesture_configure(app);
+    bt_model->macro = ATRACK_MALLOC(sizeof(Macro));
+    macro_load(bt_model->macro, BT_MACRO_PATH);
+    // Timings are built here, a press only starts the TX
+    bt_model->subghz = ATRACK_MALLOC(sizeof(SubghzMirror));
+    memset(bt_model->subghz, 0, sizeof(SubghzMirror));
+    subghz_mirror_load(bt_model->subghz, BT_SUBGHZ_PATH);
+    // The worker reads everything above from its first loop, start it once all of it exists.
+    // The bridge and the CLI push to it, they come after
+    app->comm_thread = furi_thread_alloc();
+    furi_thread_set_name(app->comm_thread, "Comm_Thread");
+    furi_thread_set_stack_size(app->comm_thread, 2048);
+    furi_thread_set_context(app->comm_thread, app);
+    furi_thread_set_callback(app->comm_thread, bt_comm_worker);
+    furi_thread_start(app->comm_thread);
+    app->comm_thread_id = furi_thread_get_id(app->comm_thread);
+    bt_uart_bridge_update(app);
+    app->uart_bridge_enb = app->uart_bridge != NULL;
+    bt_cli_register(app);
 
     // Variable Items
     app->variable_item_list_config = variable_item_list_alloc();
@@ -101,6 +193,15 @@ App* app_alloc() {
     // Device Name
     app->device_name_item = futils_variable_item_init(
         app->variable_item_list_config, DEVICE_NAME_LABEL, bt_model->device_name, 1, 0, NULL, NULL);
+    // Name Policy
+    app->name_policy_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        NAME_POLICY_LABEL,
+        name_policy_names[bt_model->name_policy_idx],
+        COUNT_OF(name_policy_names),
+        bt_model->name_policy_idx,
+        variable_item_setting_changed,
+        app);
     // Beacon Period
     app->beacon_period_item = futils_variable_item_init(
         app->variable_item_list_config,
@@ -119,13 +220,156 @@ App* app_alloc() {
         bt_model->beacon_duration_idx,
         variable_item_setting_changed,
         app);
-    // Randomize MAC
-    app->randomize_mac_enb_item = futils_variable_item_init(
+    // Advertising Schedule
+    app->adv_schedule_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        ADV_SCHEDULE_LABEL,
+        adv_schedule_names[bt_model->adv_schedule],
+        COUNT_OF(adv_schedule_names),
+        bt_model->adv_schedule,
+        variable_item_setting_changed,
+        app);
+    // Send Count
+    app->send_count_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        SEND_COUNT_LABEL,
+        send_count_names[bt_model->send_count_idx],
+        COUNT_OF(send_count_names),
+        bt_model->send_count_idx,
+        variable_item_setting_changed,
+        app);
+    // Advertising Jitter
+    app->adv_jitter_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        ADV_JITTER_LABEL,
+        adv_jitter_names[bt_model->adv_jitter_idx],
+        COUNT_OF(adv_jitter_names),
+        bt_model->adv_jitter_idx,
+        variable_item_setting_changed,
+        app);
+    // Radio Profile, TX Power and Channels edit the selected profile
+    const RadioProfile* profile = &bt_model->profiles[bt_model->profile_idx];
+    app->profile_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        PROFILE_LABEL,
+        profile_names[bt_model->profile_idx],
+        COUNT_OF(profile_names),
+        bt_model->profile_idx,
+        variable_item_setting_changed,
+        app);
+    app->tx_power_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        TX_POWER_LABEL,
+        tx_power_names[profile->tx_power_idx],
+        COUNT_OF(tx_power_names),
+        profile->tx_power_idx,
+        variable_item_setting_changed,
+        app);
+    app->channels_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        CHANNELS_LABEL,
+        channels_names[profile->channels_idx],
+        COUNT_OF(channels_names),
+        profile->channels_idx,
+        variable_item_setting_changed,
+        app);
+    // MAC Mode
+    app->mac_mode_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        MAC_MODE_LABEL,
+        mac_mode_names[bt_model->mac_mode],
+        COUNT_OF(mac_mode_names),
+        bt_model->mac_mode,
+        variable_item_setting_changed,
+        app);
+    // RPA Rotation
+    app->rpa_rotation_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        RPA_ROTATION_LABEL,
+        rpa_rotation_names[bt_model->rpa_rotation_idx],
+        COUNT_OF(rpa_rotation_names),
+        bt_model->rpa_rotation_idx,
+        variable_item_setting_changed,
+        app);
+    // Custom MAC
+    app->custom_mac_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        CUSTOM_MAC_LABEL,
+        furi_string_get_cstr(bt_model->custom_mac_str),
+        1,
+        0,
+        NULL,
+        NULL);
+    // Remote Mode
+    app->remote_mode_enb_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        REMOTE_MODE_LABEL,
+        remote_mode_names[bt_model->remote_mode_enb],
+        COUNT_OF(remote_mode_names),
+        bt_model->remote_mode_enb,
+        variable_item_setting_changed,
+        app);
+    // Multi Press window
+    app->multi_press_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        MULTI_PRESS_LABEL,
+        multi_press_names[bt_model->multi_press_idx],
+        COUNT_OF(multi_press_names),
+        bt_model->multi_press_idx,
+        variable_item_setting_changed,
+        app);
+    // Long Press time
+    app->long_press_item = futils_variable_item_init(
         app->variable_item_list_config,
-        RANDOMIZE_MAC_LABEL,
-        randomize_mac_names[bt_model->randomize_mac_enb],
-        COUNT_OF(randomize_mac_names),
-        bt_model->randomize_mac_enb,
+        LONG_PRESS_LABEL,
+        long_press_names[bt_model->long_press_idx],
+        COUNT_OF(long_press_names),
+        bt_model->long_press_idx,
+        variable_item_setting_changed,
+        app);
+    // Hold To Dim
+    app->hold_to_dim_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        HOLD_TO_DIM_LABEL,
+        hold_to_dim_names[bt_model->hold_to_dim_enb],
+        COUNT_OF(hold_to_dim_names),
+        bt_model->hold_to_dim_enb,
+        variable_item_setting_changed,
+        app);
+    // Sensor Mode
+    app->sensor_mode_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        SENSOR_MODE_LABEL,
+        sensor_mode_names[bt_model->sensor_mode],
+        COUNT_OF(sensor_mode_names),
+        bt_model->sensor_mode,
+        variable_item_setting_changed,
+        app);
+    // UART Bridge
+    app->uart_bridge_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        UART_BRIDGE_LABEL,
+        uart_bridge_names[app->uart_bridge_enb],
+        COUNT_OF(uart_bridge_names),
+        app->uart_bridge_enb,
+        variable_item_setting_changed,
+        app);
+    // Sub-GHz Mirror
+    app->subghz_mirror_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        SUBGHZ_MIRROR_LABEL,
+        subghz_mirror_names[bt_model->subghz_mirror_enb],
+        COUNT_OF(subghz_mirror_names),
+        bt_model->subghz_mirror_enb,
+        variable_item_setting_changed,
+        app);
+    // Coexistence with the beacon of another app
+    app->coex_item = futils_variable_item_init(
+        app->variable_item_list_config,
+        COEX_LABEL,
+        coex_names[bt_model->coex_enb],
+        COUNT_OF(coex_names),
+        bt_model->coex_enb,
         variable_item_setting_changed,
         app);
 
@@ -152,6 +396,45 @@ App* app_alloc() {
         \n  - release on the Flipper App\n  Store";
     widget_add_text_scroll_element(app->widget_about, 0, 0, 128, 64, about_text);
 
+    // Sub-GHz Mirror
+    app->view_sghz = view_alloc();
+    view_set_draw_callback(app->view_sghz, subghz_view_draw_callback);
+    view_set_input_callback(app->view_sghz, subghz_view_input_callback);
+    view_set_enter_callback(app->view_sghz, subghz_view_enter_callback);
+    view_set_previous_callback(app->view_sghz, navigation_submenu_callback);
+    view_set_context(app->view_sghz, app);
+    view_allocate_model(app->view_sghz, ViewModelTypeLocking, sizeof(SubghzViewModel));
+    view_dispatcher_add_view(app->view_dispatcher, ViewSghz, app->view_sghz);
+
+    // TX Log
+    app->view_tx_log = view_alloc();
+    view_set_draw_callback(app->view_tx_log, tx_log_view_draw_callback);
+    view_set_input_callback(app->view_tx_log, tx_log_view_input_callback);
+    view_set_enter_callback(app->view_tx_log, tx_log_view_enter_callback);
+    view_set_previous_callback(app->view_tx_log, navigation_submenu_callback);
+    view_set_context(app->view_tx_log, app);
+    view_allocate_model(app->view_tx_log, ViewModelTypeLocking, sizeof(TxLogViewModel));
+    view_dispatcher_add_view(app->view_dispatcher, ViewTxLog, app->view_tx_log);
+
+    // File Viewer
+    app->file_viewer = file_viewer_alloc();
+    view_set_previous_callback(
+        file_viewer_get_view(app->file_viewer), navigation_submenu_callback);
+    view_dispatcher_add_view(
+        app->view_dispatcher, ViewResp, file_viewer_get_view(app->file_viewer));
+
+#if ALLOC_TRACKER
+    // Heap Stats
+    app->view_heap_stats = view_alloc();
+    view_set_draw_callback(app->view_heap_stats, heap_stats_draw_callback);
+    view_set_input_callback(app->view_heap_stats, heap_stats_input_callback);
+    view_set_enter_callback(app->view_heap_stats, heap_stats_enter_callback);
+    view_set_previous_callback(app->view_heap_stats, navigation_submenu_callback);
+    view_set_context(app->view_heap_stats, app);
+    view_allocate_model(app->view_heap_stats, ViewModelTypeLocking, sizeof(HeapStatsModel));
+    view_dispatcher_add_view(app->view_dispatcher, ViewHeapStats, app->view_heap_stats);
+#endif
+
     return app;
 }
 
@@ -163,6 +446,31 @@ App* app_alloc() {
 void app_free(App* app) {
     BtBeacon* bt_model = view_get_model(app->view_bt);
 
+    // The bridge and the CLI push to the worker, stop them first
+    bt_cli_unregister(app);
+    if(app->uart_bridge) {
+        uart_bridge_free(app->uart_bridge);
+    }
+    // Stop thread and wait for exit
+    furi_thread_flags_set(app->comm_thread_id, ThreadCommStop);
+    furi_thread_join(app->comm_thread);
+    furi_thread_free(app->comm_thread);
+    furi_message_queue_free(app->cmd_queue);
+    counter_store_free(bt_model->counter);
+    tx_log_free(bt_model->tx_log);
+    // Nothing draws random numbers from here on, the refills still queued call into the app
+    futils_random_drain();
+    furi_timer_flush();
+    furi_timer_free(app->timer_draw);
+    furi_timer_free(app->timer_reset_key);
+    furi_timer_free(app->timer_gesture);
+    furi_timer_free(bt_model->timer_dim);
+    furi_timer_free(bt_model->timer_sensor);
+    furi_timer_free(bt_model->timer_rpa);
+    ATRACK_FREE(bt_model->macro);
+    ATRACK_FREE(bt_model->subghz);
+    furi_timer_free(bt_model->timer_reset_beacon);
+
     if(furi_hal_bt_extra_beacon_is_active()) {
         furi_check(furi_hal_bt_extra_beacon_stop());
     }
@@ -181,11 +489,14 @@ void app_free(App* app) {
     furi_mutex_free(bt_model->worker_mutex);
 
     furi_string_free(bt_model->mac_address_str);
-    free(bt_model->device_name);
+    furi_string_free(bt_model->custom_mac_str);
+    ATRACK_FREE(bt_model->device_name);
 
     view_dispatcher_remove_view(app->view_dispatcher, ViewTextInputDeviceName);
     text_input_free(app->text_input_device_name);
-    free(app->temp_device_name);
+    view_dispatcher_remove_view(app->view_dispatcher, ViewTextInputCustomMac);
+    uart_text_input_free(app->text_input_custom_mac);
+    ATRACK_FREE(app->temp_device_name);
 
     view_dispatcher_remove_view(app->view_dispatcher, ViewSubmenu);
     submenu_free(app->submenu);
@@ -193,11 +504,21 @@ void app_free(App* app) {
     variable_item_list_free(app->variable_item_list_config);
     view_dispatcher_remove_view(app->view_dispatcher, ViewBt);
     view_free(app->view_bt);
+    view_dispatcher_remove_view(app->view_dispatcher, ViewSghz);
+    view_free(app->view_sghz);
+    view_dispatcher_remove_view(app->view_dispatcher, ViewTxLog);
+    view_free(app->view_tx_log);
+    view_dispatcher_remove_view(app->view_dispatcher, ViewResp);
+    file_viewer_free(app->file_viewer);
     view_dispatcher_remove_view(app->view_dispatcher, ViewAbout);
     widget_free(app->widget_about);
+#if ALLOC_TRACKER
+    view_dispatcher_remove_view(app->view_dispatcher, ViewHeapStats);
+    view_free(app->view_heap_stats);
+#endif
 
     view_dispatcher_free(app->view_dispatcher);
     furi_record_close(RECORD_GUI);
 
-    free(app);
+    ATRACK_FREE(app);
 }
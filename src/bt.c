@@ -2,6 +2,14 @@
 #include "app.h"
 #include "bt_home_remote_icons.h"
 #include "libs/furi_utils.h"
+#include <gui/elements.h>
+
+extern const uint32_t rpa_rotation_values[3];
+extern const GapAdvPowerLevel tx_power_values[6];
+extern const GapAdvChannelMap channels_values[4];
+extern const char* profile_names[PROFILE_COUNT];
+extern const NamePolicyOption name_policy_values[NAME_POLICY_COUNT];
+extern const AdvJitter adv_jitter_values[4];
 
 /**
  * @brief      Check if sending a request is allowed
@@ -22,10 +30,98 @@ void timer_beacon_reset_callback(void* context) {
     furi_thread_flags_set(app->comm_thread_id, ThreadCommStopCmd);
 }
 
-bool make_packet(BtBeacon* bt_model, uint8_t* _size, uint8_t** _packet) {
-    uint8_t* packet = malloc(EXTRA_BEACON_MAX_DATA_SIZE);
+/**
+ * @brief      Callback of the timer_sensor, asks the worker to refresh the readings.
+ * @param      context  The context - App object.
+*/
+void timer_sensor_callback(void* context) {
+    App* app = (App*)context;
+    furi_thread_flags_set(app->comm_thread_id, ThreadCommSensorCmd);
+}
+
+/**
+ * @brief      Callback of the timer_rpa, asks the worker to rotate the address.
+ * @param      context  The context - App object.
+*/
+void timer_rpa_callback(void* context) {
+    App* app = (App*)context;
+    furi_thread_flags_set(app->comm_thread_id, ThreadCommRpaCmd);
+}
+
+/**
+ * @brief      Callback of the timer_dim, sends the dimmer steps merged while rate limited.
+ * @param      context  The context - App object.
+*/
+void timer_dim_callback(void* context) {
+    App* app = (App*)context;
+    furi_thread_flags_set(app->comm_thread_id, ThreadCommDimCmd);
+}
+
+/**
+ * @brief      Map a key to its BTHome button index in remote mode
+ * @param      key  the pressed key
+ * @return     the button index, -1 if the key is not a button
+*/
+int8_t bt_button_index(InputKey key) {
+    switch(key) {
+    case InputKeyOk:
+        return BTHomeButtonOk;
+    case InputKeyUp:
+        return BTHomeButtonUp;
+    case InputKeyDown:
+        return BTHomeButtonDown;
+    case InputKeyLeft:
+        return BTHomeButtonLeft;
+    case InputKeyRight:
+        return BTHomeButtonRight;
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief      Length of the device name a policy puts in a packet.
+ * @param      bt_model    the current model, for the device name and the press count
+ * @param      policy_idx  index in name_policy_values
+ * @param      room        bytes left in the packet for the name AD structure
+ * @param      name_type   filled with the AD type, full or shortened name
+ * @return     the name bytes, 0 to leave the name out
+*/
+static size_t bt_name_policy_len(
+    const BtBeacon* bt_model,
+    uint8_t policy_idx,
+    size_t room,
+    uint8_t* name_type) {
+    const NamePolicyOption* option = &name_policy_values[policy_idx];
+    size_t name_len = bt_model->device_name_len;
+    *name_type = 0x09; // Full name
+    if(option->policy == NamePolicyFirst && bt_model->name_presses >= option->limit) {
+        return 0;
+    }
+    if(option->policy == NamePolicyShort && name_len > option->limit) {
+        name_len = option->limit;
+        *name_type = 0x08; // Shortened name
+    }
+    if(2 + name_len > room && room > 2) {
+        // Not enough room for the whole name, send it shortened
+        name_len = room - 2;
+        *name_type = 0x08;
+    }
+    return name_len;
+}
+
+/**
+ * @brief      Encode a BTHome advertisement with the given name policy.
+ * @see        bt_encode_packet
+*/
+static uint8_t bt_encode_packet_policy(
+    const BtBeacon* bt_model,
+    const BtPacketPayload* payload,
+    uint8_t packet_id,
+    uint8_t* packet,
+    uint8_t* id_offset,
+    uint8_t policy_idx) {
     size_t i = 0;
-    bt_model->cnt++;
 
     // Flag data
     packet[i++] = 0x02; // length
@@ -33,59 +129,264 @@ bool make_packet(BtBeacon* bt_model, uint8_t* _size, uint8_t** _packet) {
     packet[i++] =
         0b00000110; // bit 1: “LE General Discoverable Mode”, bit 2: “BR/EDR Not Supported”
     // Service data
-    packet[i++] = 0x08; // length
+    const size_t service_len_idx = i;
+    packet[i++] = 0x00; // length, filled in below
     packet[i++] = 0x16; // Type: Flags
     // BTHome Data
-    packet[i++] = 0xD2; // UUID 1
-    packet[i++] = 0xFC; // UUID 2
+    packet[i++] = BTHOME_UUID_LO; // UUID 1
+    packet[i++] = BTHOME_UUID_HI; // UUID 2
     packet[i++] = 0b01000100; // BTHome Device Information
     // Packet Id
-    packet[i++] = 0x00; // Type: Packet ID
-    packet[i++] = bt_model->cnt; // Packet Counter
+    packet[i++] = BTHOME_OBJ_PACKET_ID; // Type: Packet ID
+    if(id_offset) {
+        *id_offset = i;
+    }
+    packet[i++] = packet_id; // Packet Counter
     // Actual Data
-    packet[i++] = 0x3A; // Type: Object ID Button
-    packet[i++] = bt_model->event_type; // Event Press
+    if(payload->kind == BtPacketSensor) {
+        // Objects must be in ascending id order
+        const BtSensorReadings* sensor = payload->sensor;
+        packet[i++] = BTHOME_OBJ_BATTERY; // Type: Battery, %
+        packet[i++] = sensor->battery;
+        packet[i++] = BTHOME_OBJ_TEMPERATURE; // Type: Temperature, 0.01 °C
+        packet[i++] = (uint16_t)sensor->temperature & 0xFF;
+        packet[i++] = (uint16_t)sensor->temperature >> 8;
+        packet[i++] = BTHOME_OBJ_VOLTAGE; // Type: Voltage, mV
+        packet[i++] = sensor->voltage & 0xFF;
+        packet[i++] = sensor->voltage >> 8;
+        if(payload->uptime) {
+            packet[i++] = BTHOME_OBJ_COUNT; // Type: Count, uptime in s
+            packet[i++] = sensor->uptime & 0xFF;
+            packet[i++] = (sensor->uptime >> 8) & 0xFF;
+            packet[i++] = (sensor->uptime >> 16) & 0xFF;
+            packet[i++] = sensor->uptime >> 24;
+        }
+    } else if(payload->kind == BtPacketDimmer) {
+        packet[i++] = BTHOME_OBJ_DIMMER; // Type: Object ID Dimmer
+        packet[i++] = payload->event; // Rotation direction
+        packet[i++] = payload->steps; // Number of steps
+    } else if(bt_model->remote_mode_enb) {
+        // The object position is the button index, idle buttons report "none"
+        for(uint8_t b = 0; b < BT_HOME_BUTTON_COUNT; b++) {
+            packet[i++] = BTHOME_OBJ_BUTTON; // Type: Object ID Button
+            packet[i++] = b == payload->button ? payload->event : BTHomeNoEvent;
+        }
+    } else {
+        packet[i++] = BTHOME_OBJ_BUTTON; // Type: Object ID Button
+        packet[i++] = payload->event; // Event Press
+    }
+    packet[service_len_idx] = i - service_len_idx - 1;
     //Device name
-    packet[i++] = bt_model->device_name_len + 1; // Lenght
-    packet[i++] = 0x09; // Full name
+    uint8_t name_type;
+    const size_t name_len =
+        bt_name_policy_len(bt_model, policy_idx, EXTRA_BEACON_MAX_DATA_SIZE - i, &name_type);
+    if(name_len == 0) {
+        return i;
+    }
+    if(i + 2 + name_len > EXTRA_BEACON_MAX_DATA_SIZE) {
+        FURI_LOG_E(
+            BT_TAG,
+            "Packet too big: Max = %u, Size = %u",
+            EXTRA_BEACON_MAX_DATA_SIZE,
+            i + 2 + name_len);
+        return 0;
+    }
+    packet[i++] = name_len + 1; // Lenght
+    packet[i++] = name_type;
 
-    for(size_t j = 0; j < bt_model->device_name_len; j++) {
+    for(size_t j = 0; j < name_len; j++) {
         packet[i++] = (uint8_t)bt_model->device_name[j];
     }
 
-    if(i > EXTRA_BEACON_MAX_DATA_SIZE) {
-        FURI_LOG_E(BT_TAG, "Packet too big: Max = %u, Size = %u", EXTRA_BEACON_MAX_DATA_SIZE, i);
-        free(packet);
+    return i;
+}
+
+/**
+ * @brief      Encode a BTHome advertisement into a caller provided buffer.
+ * @param      bt_model   the current model, for the device name and remote mode
+ * @param      payload    what to send
+ * @param      packet_id  the BTHome packet id
+ * @param      packet     destination, at least EXTRA_BEACON_MAX_DATA_SIZE bytes
+ * @param      id_offset  filled with the position of the packet id byte, can be NULL
+ * @return     the packet size, 0 if it doesn't fit
+*/
+uint8_t bt_encode_packet(
+    const BtBeacon* bt_model,
+    const BtPacketPayload* payload,
+    uint8_t packet_id,
+    uint8_t* packet,
+    uint8_t* id_offset) {
+    return bt_encode_packet_policy(
+        bt_model, payload, packet_id, packet, id_offset, bt_model->name_policy_idx);
+}
+
+/**
+ * @brief      Air time of one advertising PDU with this much data, on one channel.
+ * @details    LE 1M: preamble, access address, PDU header, advertiser address, data and CRC,
+ *             8 us per byte.
+ * @param      size  the advertising data size
+ * @return     the air time in us
+*/
+uint16_t bt_airtime_us(uint8_t size) {
+    return (1 + 4 + 2 + EXTRA_BEACON_MAC_ADDR_SIZE + size + 3) * 8;
+}
+
+/**
+ * @brief      Size of the current button event with every name policy.
+ * @param      bt_model  The BtBeacon model.
+ * @param      sizes     Filled with the packet size of every entry of name_policy_values.
+*/
+void bt_name_policy_sizes(const BtBeacon* bt_model, uint8_t sizes[NAME_POLICY_COUNT]) {
+    uint8_t packet[EXTRA_BEACON_MAX_DATA_SIZE];
+    const BtPacketPayload payload = {
+        .kind = BtPacketButton,
+        .button = bt_model->button_idx,
+        .event = bt_model->event_type,
+    };
+    for(uint8_t p = 0; p < NAME_POLICY_COUNT; p++) {
+        sizes[p] = bt_encode_packet_policy(bt_model, &payload, bt_model->cnt, packet, NULL, p);
+    }
+}
+
+/**
+ * @brief      Take the id of a new packet from the persisted counter.
+ * @param      bt_model  The BtBeacon model.
+ * @return     the BTHome packet id
+*/
+static uint8_t bt_next_packet_id(BtBeacon* bt_model) {
+    bt_model->cnt = (uint8_t)counter_store_next(bt_model->counter);
+    return bt_model->cnt;
+}
+
+bool make_packet(BtBeacon* bt_model, uint8_t* _size, uint8_t** _packet) {
+    uint8_t* packet = ATRACK_MALLOC(EXTRA_BEACON_MAX_DATA_SIZE);
+    const BtPacketPayload payload = {
+        .kind = bt_model->packet_kind,
+        .button = bt_model->button_idx,
+        .event = bt_model->packet_kind == BtPacketDimmer ? bt_model->dim_event :
+                                                           bt_model->event_type,
+        .steps = bt_model->dim_steps,
+        .sensor = &bt_model->sensor_sent,
+        .uptime = bt_model->sensor_mode == SensorModeUptime,
+    };
+    uint8_t size = bt_encode_packet(bt_model, &payload, bt_next_packet_id(bt_model), packet, NULL);
+    if(size == 0) {
+        ATRACK_FREE(packet);
         return false;
     }
+    if(payload.kind == BtPacketButton) {
+        // What the policy left out, against the packet with the whole name
+        uint8_t full[EXTRA_BEACON_MAX_DATA_SIZE];
+        const uint8_t full_size = bt_encode_packet_policy(
+            bt_model, &payload, bt_model->cnt, full, NULL, NAME_POLICY_ALWAYS);
+        if(full_size > size) {
+            bt_model->name_saved_bytes += full_size - size;
+        }
+        if(bt_model->name_presses < UINT8_MAX) {
+            bt_model->name_presses++;
+        }
+    }
 
-    packet = realloc(packet, i);
-    *_size = i;
+    packet = ATRACK_REALLOC(packet, size);
+    *_size = size;
     *_packet = packet;
 
     return true;
 }
 
 void randomize_mac(uint8_t address[EXTRA_BEACON_MAC_ADDR_SIZE]) {
-    furi_hal_random_fill_buf(address, EXTRA_BEACON_MAC_ADDR_SIZE);
+    futils_random_fill(address, EXTRA_BEACON_MAC_ADDR_SIZE);
+}
+
+/**
+ * @brief      Set the beacon address from the MAC mode.
+ * @details    The address is printed for the view, then stored in the order the beacon expects.
+ *             Static addresses only need this on load and on config change.
+ * @param      bt_model  The BtBeacon model.
+*/
+void bt_set_address(BtBeacon* bt_model) {
+    const uint8_t fixed_mac[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+    uint8_t address[EXTRA_BEACON_MAC_ADDR_SIZE];
+    uint8_t random[RPA_HASH_SIZE];
+    switch(bt_model->mac_mode) {
+    case MacModeRandom:
+        randomize_mac(address);
+        break;
+    case MacModeRpa:
+        futils_random_fill(random, RPA_HASH_SIZE);
+        furi_check(rpa_generate(&bt_model->rpa, random, address));
+        break;
+    case MacModeCustom:
+        memcpy(address, bt_model->custom_mac, EXTRA_BEACON_MAC_ADDR_SIZE);
+        break;
+    default:
+        memcpy(address, fixed_mac, EXTRA_BEACON_MAC_ADDR_SIZE);
+        break;
+    }
+    bt_model->config.address_type = bt_model->mac_mode == MacModeRpa ? GapAddressTypeRandom :
+                                                                        GapAddressTypePublic;
+
+    pretty_print_mac(bt_model->mac_address_str, address, EXTRA_BEACON_MAC_ADDR_SIZE - 1);
+    FURI_LOG_I(BT_TAG, "Current MAC address: %s", furi_string_get_cstr(bt_model->mac_address_str));
+    // The beacon expects the MAC address in reverse order
+    for(size_t i = 0; i < EXTRA_BEACON_MAC_ADDR_SIZE; i++) {
+        bt_model->config.address[i] = address[EXTRA_BEACON_MAC_ADDR_SIZE - 1 - i];
+    }
 }
 
-void pretty_print_mac(FuriString* mac_str, uint8_t address[EXTRA_BEACON_MAC_ADDR_SIZE]) {
+/**
+ * @brief      Check if the MAC mode draws a new address on every view enter.
+*/
+bool bt_address_is_dynamic(const BtBeacon* bt_model) {
+    return bt_model->mac_mode == MacModeRandom || bt_model->mac_mode == MacModeRpa;
+}
+
+/**
+ * @brief      Format a MAC address as AA:BB:CC:DD:EE:FF.
+ * @param      mac_str  The destination.
+ * @param      address  The address, MSB first.
+ * @param      len      The bytes to print, the header of the MAC page only fits 5 of them.
+*/
+void pretty_print_mac(
+    FuriString* mac_str,
+    const uint8_t address[EXTRA_BEACON_MAC_ADDR_SIZE],
+    size_t len) {
     furi_string_set_str(mac_str, "");
-    for(size_t i = 0; i < EXTRA_BEACON_MAC_ADDR_SIZE - 1; i++) {
+    for(size_t i = 0; i < len; i++) {
         furi_string_cat_printf(mac_str, "%02X", address[i]);
-        if(i < EXTRA_BEACON_MAC_ADDR_SIZE - 2) {
+        if(i < len - 1) {
             furi_string_cat_str(mac_str, ":");
         }
     }
-    FURI_LOG_I(BT_TAG, "Current MAC address: %s", furi_string_get_cstr(mac_str));
+}
+
+/**
+ * @brief      Parse a MAC address, the bytes may be separated by ':' or '-'.
+ * @param      str      The string.
+ * @param      address  The address, MSB first, left untouched if the string is not valid.
+ * @return     true if the string is a valid MAC
+*/
+bool parse_mac(const char* str, uint8_t address[EXTRA_BEACON_MAC_ADDR_SIZE]) {
+    char hex[EXTRA_BEACON_MAC_ADDR_SIZE * 2 + 1];
+    size_t len = 0;
+    for(; *str != '\0'; str++) {
+        if(*str == ':' || *str == '-') {
+            continue;
+        }
+        if(len == sizeof(hex) - 1) {
+            return false;
+        }
+        hex[len++] = *str;
+    }
+    hex[len] = '\0';
+    return futils_hex_to_bytes(hex, address, EXTRA_BEACON_MAC_ADDR_SIZE);
 }
 /**
  * @brief      Callback of the timer_draw to update the canvas.
  * @details    This function is called when the timer_draw ticks. Also update the data
  * @param      context  The context - App object.
 */
-static void view_bt_timer_callback(void* context) {
+void view_bt_timer_callback(void* context) {
     App* app = (App*)context;
     BtBeacon* bt_model = view_get_model(app->view_bt);
     // If the mutex is not available the canvas is not finished drawing, so skip this timer tick.
@@ -97,6 +398,25 @@ static void view_bt_timer_callback(void* context) {
     }
 }
 
+/**
+ * @brief      Pre-build the macro packets with the current config.
+ * @details    During playback each step is then only a data swap plus the packet id.
+ * @param      app  The App object.
+*/
+void bt_macro_build(App* app) {
+    BtBeacon* bt_model = view_get_model(app->view_bt);
+    Macro* macro = bt_model->macro;
+    for(uint8_t i = 0; i < macro->step_count; i++) {
+        MacroStep* step = &macro->steps[i];
+        const BtPacketPayload payload = {
+            .kind = BtPacketButton,
+            .button = step->button,
+            .event = step->event,
+        };
+        step->size = bt_encode_packet(bt_model, &payload, 0, step->packet, &step->id_offset);
+    }
+}
+
 /**
  * @brief      Callback of the frame screen on enter.
  * @details    Prepare the timer_draw and reset get status.
@@ -104,39 +424,36 @@ static void view_bt_timer_callback(void* context) {
 */
 void bt_enter_callback(void* context) {
     App* app = (App*)context;
+    const uint32_t enter_tick = furi_get_tick();
     app->current_view = ViewBt;
     BtBeacon* bt_model = view_get_model(app->view_bt);
+    atrack_op_begin(AtrackOpViewEnter);
     // Beacon Setup
     FURI_LOG_I(BT_TAG, "%u, %u", bt_model->beacon_period, bt_model->beacon_duration);
     bt_model->config.min_adv_interval_ms = bt_model->beacon_period;
     bt_model->config.max_adv_interval_ms = bt_model->beacon_period * 1.5;
 
-    const uint8_t fixed_mac[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
-    if(bt_model->randomize_mac_enb) {
-        randomize_mac(bt_model->config.address);
-    } else {
-        memcpy(bt_model->config.address, fixed_mac, EXTRA_BEACON_MAC_ADDR_SIZE);
+    if(bt_address_is_dynamic(bt_model)) {
+        bt_set_address(bt_model);
     }
-
-    pretty_print_mac(bt_model->mac_address_str, bt_model->config.address);
-    // The beacon expects the MAC address in reverse order
-    futils_reverse_array_uint8(bt_model->config.address, EXTRA_BEACON_MAC_ADDR_SIZE);
-    bt_model->timer_reset_beacon =
-        furi_timer_alloc(timer_beacon_reset_callback, FuriTimerTypeOnce, context);
+    bt_model->rpa_pending = false;
     // End Beacon
-    app->timer_draw = furi_timer_alloc(view_bt_timer_callback, FuriTimerTypePeriodic, context);
+    bt_macro_build(app);
+    // Timers and worker are persistent, just wake them up
     furi_timer_start(app->timer_draw, furi_ms_to_ticks(DRAW_PERIOD));
-
-    app->timer_reset_key =
-        furi_timer_alloc(view_timer_key_reset_callback, FuriTimerTypeOnce, context);
-
-    app->comm_thread = furi_thread_alloc();
-    furi_thread_set_name(app->comm_thread, "Comm_Thread");
-    furi_thread_set_stack_size(app->comm_thread, 2048);
-    furi_thread_set_context(app->comm_thread, app);
-    furi_thread_set_callback(app->comm_thread, bt_comm_worker);
-    furi_thread_start(app->comm_thread);
-    app->comm_thread_id = furi_thread_get_id(app->comm_thread);
+    app->bt_view_active = true;
+    furi_thread_flags_set(app->comm_thread_id, ThreadCommResume);
+    if(bt_model->sensor_mode != SensorModeOff) {
+        furi_thread_flags_set(app->comm_thread_id, ThreadCommSensorCmd);
+        furi_timer_start(bt_model->timer_sensor, furi_ms_to_ticks(SENSOR_REFRESH_PERIOD));
+    }
+    if(bt_model->mac_mode == MacModeRpa) {
+        furi_timer_start(
+            bt_model->timer_rpa,
+            furi_ms_to_ticks(rpa_rotation_values[bt_model->rpa_rotation_idx]));
+    }
+    FURI_LOG_I(BT_TAG, "View enter took %lu ticks", furi_get_tick() - enter_tick);
+    atrack_op_end(AtrackOpViewEnter);
 }
 
 /**
@@ -146,23 +463,73 @@ void bt_enter_callback(void* context) {
 void bt_exit_callback(void* context) {
     App* app = (App*)context;
     BtBeacon* bt_model = view_get_model(app->view_bt);
-    furi_timer_flush();
+    const uint32_t exit_tick = furi_get_tick();
     furi_timer_stop(app->timer_draw);
-    furi_timer_free(app->timer_draw);
-    app->timer_draw = NULL;
     furi_timer_stop(app->timer_reset_key);
-    furi_timer_free(app->timer_reset_key);
-    app->timer_reset_key = NULL;
+    furi_timer_stop(app->timer_gesture);
+    gesture_reset(&app->gesture);
     furi_timer_stop(bt_model->timer_reset_beacon);
-    furi_timer_free(bt_model->timer_reset_beacon);
-    bt_model->timer_reset_beacon = NULL;
+    furi_timer_stop(bt_model->timer_sensor);
+    furi_timer_stop(bt_model->timer_rpa);
+    // Park the worker, it stays alive until app_free()
+    app->bt_view_active = false;
+    furi_thread_flags_set(app->comm_thread_id, ThreadCommSuspend);
+    FURI_LOG_I(BT_TAG, "View exit took %lu ticks", furi_get_tick() - exit_tick);
+}
 
-    // Stop thread and wait for exit
-    if(app->comm_thread) {
-        furi_thread_flags_set(app->comm_thread_id, ThreadCommStop);
-        furi_thread_join(app->comm_thread);
-        furi_thread_free(app->comm_thread);
+/**
+ * @brief      Draw the macro playback status next to the page header.
+ * @param      canvas  The canvas to draw on.
+ * @param      macro   The Macro object.
+*/
+static void bt_draw_macro_status(Canvas* canvas, const Macro* macro) {
+    char status[16];
+    if(!macro->loaded) {
+        snprintf(status, sizeof(status), "no file");
+    } else if(macro->running) {
+        snprintf(status, sizeof(status), "%u/%u", macro->curr_step + 1, macro->step_count);
+    } else {
+        snprintf(
+            status,
+            sizeof(status),
+            "%u st. +%lums",
+            macro->step_count,
+            macro->max_late_ticks * 1000 / furi_kernel_get_tick_frequency());
+    }
+    canvas_draw_str(canvas, 40, 8, status);
+}
+
+/**
+ * @brief      Draw the decoded packet, the text is built by the worker when the packet changes.
+ * @param      canvas    The canvas to draw on.
+ * @param      bt_model  The BtBeacon model.
+*/
+static void bt_draw_inspector(Canvas* canvas, const BtBeacon* bt_model) {
+    const AdvInspect* inspect = &bt_model->inspect;
+    if(inspect->size == 0) {
+        canvas_draw_str(canvas, 0, 18, "Nothing sent yet");
+        return;
+    }
+    canvas_set_font(canvas, FontKeyboard);
+    for(uint8_t i = 0; i < BT_INSPECT_ROWS && bt_model->inspect_top + i < inspect->line_count;
+        i++) {
+        canvas_draw_str(canvas, 0, 18 + i * 10, inspect->lines[bt_model->inspect_top + i]);
     }
+    canvas_set_font(canvas, FontSecondary);
+    elements_scrollbar(canvas, bt_model->inspect_top, inspect->line_count);
+}
+
+/**
+ * @brief      Draw the D-pad used in remote mode, the last pressed key is highlighted.
+ * @param      canvas      The canvas to draw on.
+ * @param      last_input  The last pressed key.
+*/
+static void bt_draw_dpad(Canvas* canvas, uint8_t last_input) {
+    canvas_draw_icon(canvas, 87, 10, last_input == InputKeyUp ? &I_up_hover : &I_up);
+    canvas_draw_icon(canvas, 68, 27, last_input == InputKeyLeft ? &I_left_hover : &I_left);
+    canvas_draw_icon(canvas, 87, 27, last_input == InputKeyOk ? &I_ok_hover : &I_ok);
+    canvas_draw_icon(canvas, 106, 27, last_input == InputKeyRight ? &I_right_hover : &I_right);
+    canvas_draw_icon(canvas, 87, 44, last_input == InputKeyDown ? &I_down_hover : &I_down);
 }
 
 /**
@@ -175,54 +542,84 @@ void bt_draw_callback(Canvas* canvas, void* model) {
     BtBeacon* bt_model = (BtBeacon*)model;
     const uint8_t status = bt_model->status;
     const uint8_t packet_id = bt_model->cnt;
+    const bool inspector = !bt_model->remote_mode_enb && bt_model->curr_page == PageInspector;
     FuriString* mac_address = furi_string_alloc();
-    furi_string_set_str(mac_address, furi_string_get_cstr(bt_model->mac_address_str));
 
     if(furi_mutex_acquire(bt_model->worker_mutex, FuriWaitForever) == FuriStatusOk) {
+        // The worker rotates the address under the mutex
+        furi_string_set_str(mac_address, furi_string_get_cstr(bt_model->mac_address_str));
         canvas_set_bitmap_mode(canvas, true);
 
-        switch(bt_model->curr_page) {
-        case PageFirst:
-            futils_draw_header(canvas, "Dehum. Switch", bt_model->curr_page, 8);
-            canvas_draw_icon(canvas, 123, 2, &I_ButtonRightSmall_3x5);
-            break;
+        if(bt_model->remote_mode_enb) {
+            futils_draw_header(canvas, "Remote", PageFirst, 8);
+            bt_draw_dpad(canvas, bt_model->last_input);
+            canvas_draw_str(canvas, 105, 60, "#");
+            char cnt[6];
+            snprintf(cnt, sizeof(cnt), "%u", packet_id);
+            canvas_draw_str(canvas, 111, 60, cnt);
+        } else {
+            switch(bt_model->curr_page) {
+            case PageFirst:
+                futils_draw_header(canvas, "Dehum. Switch", bt_model->curr_page, 8);
+                canvas_draw_icon(canvas, 123, 2, &I_ButtonRightSmall_3x5);
+                break;
 
-        case PageSecond:
-            futils_draw_header(canvas, "MAC", bt_model->curr_page, 8);
-            canvas_draw_icon(canvas, 111, 2, &I_ButtonLeftSmall_3x5);
-            canvas_draw_icon(canvas, 123, 2, &I_ButtonRightSmall_3x5);
-            canvas_draw_str(canvas, 35, 8, furi_string_get_cstr(mac_address));
-            break;
+            case PageSecond:
+                futils_draw_header(canvas, "MAC", bt_model->curr_page, 8);
+                canvas_draw_icon(canvas, 111, 2, &I_ButtonLeftSmall_3x5);
+                canvas_draw_icon(canvas, 123, 2, &I_ButtonRightSmall_3x5);
+                canvas_draw_str(canvas, 35, 8, furi_string_get_cstr(mac_address));
+                break;
 
-        case PageThird:
-            futils_draw_header(canvas, "Device Name", bt_model->curr_page, 8);
-            canvas_draw_icon(canvas, 111, 2, &I_ButtonLeftSmall_3x5);
-            canvas_draw_str(canvas, 75, 8, bt_model->device_name);
-            break;
-        default:
-            break;
-        }
-        canvas_draw_str(canvas, 87, 60, "Cnt:");
-        char cnt[6];
-        snprintf(cnt, sizeof(cnt), "%u", packet_id);
-        canvas_draw_str(canvas, 111, 60, cnt);
+            case PageThird:
+                futils_draw_header(canvas, "Device Name", bt_model->curr_page, 8);
+                canvas_draw_icon(canvas, 111, 2, &I_ButtonLeftSmall_3x5);
+                canvas_draw_icon(canvas, 123, 2, &I_ButtonRightSmall_3x5);
+                canvas_draw_str(canvas, 75, 8, bt_model->device_name);
+                break;
 
-        canvas_draw_icon(canvas, 93, 19, &I_BLE_beacon_7x8);
-        if(bt_model->last_input == InputKeyOk) {
-            canvas_draw_icon(canvas, 87, 28, &I_ok_hover);
-        } else {
-            canvas_draw_icon(canvas, 87, 28, &I_ok);
+            case PageInspector:
+                futils_draw_header(canvas, "Packet", bt_model->curr_page, 8);
+                canvas_draw_icon(canvas, 111, 2, &I_ButtonLeftSmall_3x5);
+                canvas_draw_icon(canvas, 123, 2, &I_ButtonRightSmall_3x5);
+                bt_draw_inspector(canvas, bt_model);
+                break;
+
+            case PageMacro:
+                futils_draw_header(canvas, "Macro", bt_model->curr_page, 8);
+                canvas_draw_icon(canvas, 111, 2, &I_ButtonLeftSmall_3x5);
+                bt_draw_macro_status(canvas, bt_model->macro);
+                break;
+            default:
+                break;
+            }
+            if(!inspector) {
+                canvas_draw_str(canvas, 87, 60, "Cnt:");
+                char cnt[6];
+                snprintf(cnt, sizeof(cnt), "%u", packet_id);
+                canvas_draw_str(canvas, 111, 60, cnt);
+
+                canvas_draw_icon(canvas, 93, 19, &I_BLE_beacon_7x8);
+                if(bt_model->last_input == InputKeyOk) {
+                    canvas_draw_icon(canvas, 87, 28, &I_ok_hover);
+                } else {
+                    canvas_draw_icon(canvas, 87, 28, &I_ok);
+                }
+            }
         }
 
-        switch(status) {
-        case BEACON_INACTIVE:
-            canvas_draw_icon(canvas, -1, 16, &I_DolphinCommon);
-            break;
-        case BEACON_BUSY:
-            canvas_draw_icon(canvas, 0, 9, &I_NFC_dolphin_emulation_51x64);
-            break;
-        default:
-            break;
+        // The decoded packet takes the whole page
+        if(!inspector) {
+            switch(status) {
+            case BEACON_INACTIVE:
+                canvas_draw_icon(canvas, -1, 16, &I_DolphinCommon);
+                break;
+            case BEACON_BUSY:
+                canvas_draw_icon(canvas, 0, 9, &I_NFC_dolphin_emulation_51x64);
+                break;
+            default:
+                break;
+            }
         }
 
         furi_check(furi_mutex_release(bt_model->worker_mutex) == FuriStatusOk);
@@ -230,6 +627,116 @@ void bt_draw_callback(Canvas* canvas, void* model) {
     furi_string_free(mac_address);
 }
 
+/**
+ * @brief      Request the worker to send a button event.
+ * @param      app     The App object.
+ * @param      button  The BTHome button index.
+ * @param      event   The BTHomeEventType to send.
+*/
+void bt_send_event(App* app, uint8_t button, uint8_t event) {
+    BtBeacon* bt_model = view_get_model(app->view_bt);
+    if(allow_cmd_bt(bt_model)) {
+        bt_model->button_idx = button;
+        bt_model->event_type = event;
+        bt_model->press_tick = furi_get_tick();
+        furi_thread_flags_set(app->comm_thread_id, ThreadCommSendCmd);
+    }
+}
+
+/**
+ * @brief      Parse an external command line and queue it for the comm worker.
+ * @details    Called from the UART bridge and CLI threads, nothing is allocated per line.
+ * @param      line     The command line, modified in place.
+ * @param      error    Set to a short reason when the line is rejected.
+ * @param      context  The context - App object.
+ * @return     true if the command was queued
+*/
+bool bt_cmd_line_callback(char* line, const char** error, void* context) {
+    App* app = (App*)context;
+    const CmdParser parser = {
+        .profile_names = profile_names,
+        .profile_count = PROFILE_COUNT,
+        .button_count = BT_HOME_BUTTON_COUNT,
+    };
+    Cmd cmd;
+    if(!cmd_parse(&parser, line, &cmd, error)) {
+        return false;
+    }
+    if(!app->bt_view_active) {
+        *error = "remote view closed";
+        return false;
+    }
+    cmd.tick = furi_get_tick();
+    if(furi_message_queue_put(app->cmd_queue, &cmd, 0) != FuriStatusOk) {
+        *error = "queue full";
+        return false;
+    }
+    furi_thread_flags_set(app->comm_thread_id, ThreadCommExtCmd);
+    return true;
+}
+
+/**
+ * @brief      Start or stop the UART bridge to match the config.
+ * @param      app  The App object.
+*/
+void bt_uart_bridge_update(App* app) {
+    if(app->uart_bridge_enb && app->uart_bridge == NULL) {
+        app->uart_bridge = uart_bridge_alloc(bt_cmd_line_callback, app);
+    } else if(!app->uart_bridge_enb && app->uart_bridge != NULL) {
+        uart_bridge_free(app->uart_bridge);
+        app->uart_bridge = NULL;
+    }
+}
+
+/**
+ * @brief      Gesture recognizer output, called from the GUI thread.
+ * @param      key      The BTHome button index.
+ * @param      event    The recognized BTHomeEventType.
+ * @param      context  The context - App object.
+*/
+static void bt_gesture_callback(uint8_t key, uint8_t event, void* context) {
+    App* app = (App*)context;
+    FURI_LOG_D(BT_TAG, "Gesture: button %u, event 0x%02X", key, event);
+    bt_send_event(app, key, event);
+}
+
+/**
+ * @brief      Apply the configured press windows to the gesture recognizer.
+ * @param      app  The App object.
+*/
+void bt_gesture_configure(App* app) {
+    BtBeacon* bt_model = view_get_model(app->view_bt);
+    GestureConfig config = {
+        .multi_window_ms = bt_model->multi_press_window,
+        .long_ms = bt_model->long_press_time,
+        .max_presses = bt_model->multi_press_window ? GESTURE_MAX_PRESSES : 1,
+    };
+    gesture_init(&app->gesture, &config, bt_gesture_callback, app);
+}
+
+/**
+ * @brief      Arm the gesture timer for the next pending deadline, if any.
+ * @param      app  The App object.
+*/
+void bt_gesture_rearm(App* app) {
+    uint32_t deadline;
+    if(gesture_next_deadline(&app->gesture, &deadline)) {
+        int32_t delay = (int32_t)(deadline - furi_get_tick());
+        furi_timer_start(app->timer_gesture, delay > 0 ? delay : 1);
+    } else {
+        furi_timer_stop(app->timer_gesture);
+    }
+}
+
+/**
+ * @brief      Callback of the timer_gesture, hands the tick to the GUI thread.
+ * @param      context  The context - App object.
+*/
+void bt_gesture_timer_callback(void* context) {
+    App* app = (App*)context;
+    view_dispatcher_send_custom_event(app->view_dispatcher, EventIdGestureTick);
+}
+
 /**
  * @brief      Callback for bt screen input.
  * @details    This function is called when the user presses a button while on the bt screen.
@@ -251,6 +758,57 @@ bool bt_input_callback(InputEvent* event, void* context) {
     }
     // Status used for drawing button presses
     bt_model->last_input = event->key;
+    // On the packet page Up/Down scroll the decoded lines
+    if(!bt_model->remote_mode_enb && bt_model->curr_page == PageInspector &&
+       (event->key == InputKeyUp || event->key == InputKeyDown)) {
+        if(event->type == InputTypeShort || event->type == InputTypeRepeat) {
+            const uint8_t lines = bt_model->inspect.line_count;
+            const uint8_t last = lines > BT_INSPECT_ROWS ? lines - BT_INSPECT_ROWS : 0;
+            if(event->key == InputKeyUp && bt_model->inspect_top > 0) {
+                bt_model->inspect_top--;
+            } else if(event->key == InputKeyDown && bt_model->inspect_top < last) {
+                bt_model->inspect_top++;
+            }
+        }
+        view_dispatcher_send_custom_event(app->view_dispatcher, EventIdBtRedrawScreen);
+        return true;
+    }
+    // Up/Down drive the dimmer, one step on press and one for every repeat while held
+    if(bt_model->hold_to_dim_enb && !bt_model->remote_mode_enb &&
+       (event->key == InputKeyUp || event->key == InputKeyDown)) {
+        if(event->type == InputTypePress || event->type == InputTypeRepeat) {
+            FURI_CRITICAL_ENTER();
+            bt_model->dim_acc += event->key == InputKeyUp ? 1 : -1;
+            FURI_CRITICAL_EXIT();
+            furi_thread_flags_set(app->comm_thread_id, ThreadCommDimCmd);
+        }
+        view_dispatcher_send_custom_event(app->view_dispatcher, EventIdBtRedrawScreen);
+        return true;
+    }
+    // On the macro page Ok starts or stops the playback
+    if(!bt_model->remote_mode_enb && bt_model->curr_page == PageMacro &&
+       event->key == InputKeyOk) {
+        if(event->type == InputTypeShort) {
+            furi_thread_flags_set(app->comm_thread_id, ThreadCommMacroCmd);
+        }
+        view_dispatcher_send_custom_event(app->view_dispatcher, EventIdBtRedrawScreen);
+        return true;
+    }
+    // Button keys go through the gesture recognizer, only Ok unless in remote mode
+    int8_t button = bt_model->remote_mode_enb ? bt_button_index(event->key) :
+                    event->key == InputKeyOk  ? BTHomeButtonOk :
+                                                -1;
+    if(button >= 0) {
+        // Ticks are ms on the Flipper
+        if(event->type == InputTypePress) {
+            gesture_press(&app->gesture, button, furi_get_tick());
+        } else if(event->type == InputTypeRelease) {
+            gesture_release(&app->gesture, button, furi_get_tick());
+        }
+        bt_gesture_rearm(app);
+        view_dispatcher_send_custom_event(app->view_dispatcher, EventIdBtRedrawScreen);
+        return true;
+    }
     int8_t p_index;
     if(event->type == InputTypeShort) {
         switch(event->key) {
@@ -266,12 +824,6 @@ bool bt_input_callback(InputEvent* event, void* context) {
                 bt_model->curr_page = p_index;
             }
             break;
-        case InputKeyOk:
-            if(allow_cmd_bt(bt_model)) {
-                bt_model->event_type = BTHomeShortPress;
-                furi_thread_flags_set(app->comm_thread_id, ThreadCommSendCmd);
-            }
-            break;
         case InputKeyBack:
             view_dispatcher_send_custom_event(app->view_dispatcher, EventIdBtCheckBack);
             break;
@@ -282,12 +834,6 @@ bool bt_input_callback(InputEvent* event, void* context) {
         return true;
     } else if(event->type == InputTypeLong) {
         switch(event->key) {
-        case InputKeyOk:
-            if(allow_cmd_bt(bt_model)) {
-                bt_model->event_type = BTHomeLongPress;
-                furi_thread_flags_set(app->comm_thread_id, ThreadCommSendCmd);
-            }
-            break;
         case InputKeyBack:
             view_dispatcher_send_custom_event(app->view_dispatcher, EventIdBtCheckBack);
             break;
@@ -301,47 +847,756 @@ bool bt_input_callback(InputEvent* event, void* context) {
     return false;
 }
 
+/**
+ * @brief      Schedule settings of the model, for the worker and the fleet simulation alike.
+ * @param      bt_model  The BtBeacon model.
+ * @param      config    Filled with the settings.
+*/
+void bt_sched_config(const BtBeacon* bt_model, AdvSchedConfig* config) {
+    const AdvJitter* jitter = &adv_jitter_values[bt_model->adv_jitter_idx];
+    *config = (AdvSchedConfig){
+        .period_ms = bt_model->beacon_period,
+        .duration_ms = bt_model->beacon_duration,
+        .send_count = bt_model->send_count,
+        .adaptive = bt_model->adv_schedule == AdvScheduleAdaptive,
+        .offset_ms = jitter->offset_ms,
+        .interval_pct = jitter->interval_pct,
+    };
+}
+
+/**
+ * @brief      Log the schedule of the event that begins and the airtime it saves.
+*/
+static void bt_schedule_log(const BtBeacon* bt_model, const AdvSchedConfig* config) {
+    FURI_LOG_I(
+        BT_TAG,
+        "Schedule: %lu adv. events in %lums, %lu fixed, %u%% airtime saved",
+        adv_sched_adv_events(config, &bt_model->sched),
+        bt_model->sched.window_ms,
+        (uint32_t)config->duration_ms / config->period_ms,
+        bt_model->sched.airtime_saved_pct);
+}
+
+/**
+ * @brief      Log the advertising events sent by the schedule that just ended.
+ * @details    The extra beacon has no per-event hook, so the count is estimated from the
+ *             average interval picked by the controller (mid range plus half the advDelay).
+*/
+static void bt_schedule_report(const BtBeacon* bt_model) {
+    if(!bt_model->send_count) {
+        return;
+    }
+    const uint32_t avg_interval_x2 = bt_model->sched.min_interval_ms +
+                                     bt_model->sched.max_interval_ms + ADV_DELAY_MAX;
+    FURI_LOG_I(
+        BT_TAG,
+        "Send count %u: ~%lu adv. events sent",
+        bt_model->send_count,
+        bt_model->sched.window_ms * 2 / avg_interval_x2);
+}
+
+/**
+ * @brief      Hand the beacon to a new owner and add up the time of the one leaving.
+ * @details    The controller doesn't report the air time, it is estimated from the interval,
+ *             data size and channels of the beacon that was on air.
+ * @param      bt_model  The BtBeacon model.
+ * @param      owner     The CoexOwner now on air.
+ * @param      config    The config now on air, NULL for CoexOwnerNone.
+ * @param      data_len  The data size now on air.
+*/
+static void bt_coex_switch(
+    BtBeacon* bt_model,
+    uint8_t owner,
+    const GapExtraBeaconConfig* config,
+    uint8_t data_len) {
+    CoexStats* coex = &bt_model->coex;
+    const uint32_t now = furi_get_tick();
+    const uint32_t ms = (uint64_t)(now - coex->since) * 1000 / furi_kernel_get_tick_frequency();
+    if(coex->owner != CoexOwnerNone && coex->interval_ms) {
+        // The controller adds half of the max advDelay on average
+        const uint32_t events = ms / (coex->interval_ms + ADV_DELAY_MAX / 2);
+        coex->on_air_ms[coex->owner] += ms;
+        coex->air_ms[coex->owner] +=
+            (uint64_t)events * bt_airtime_us(coex->data_len) * coex->channels / 1000;
+    }
+    coex->owner = owner;
+    coex->since = now;
+    if(config) {
+        coex->interval_ms = config->min_adv_interval_ms;
+        coex->data_len = data_len;
+        coex->channels = __builtin_popcount(config->adv_channel_map);
+    }
+}
+
+static uint32_t bt_sched_random_below(uint32_t bound, void* context) {
+    UNUSED(context);
+    return futils_random_below(bound);
+}
+
+/**
+ * @brief      Set the interval range in the beacon config, a beacon on air is restarted with it.
+*/
+static void bt_sched_set_interval(uint32_t min_ms, uint32_t max_ms, void* context) {
+    BtBeacon* bt_model = context;
+    bt_model->config.min_adv_interval_ms = min_ms;
+    bt_model->config.max_adv_interval_ms = max_ms;
+    if(furi_hal_bt_extra_beacon_is_active()) {
+        furi_check(furi_hal_bt_extra_beacon_stop());
+        furi_check(furi_hal_bt_extra_beacon_set_config(&bt_model->config));
+        furi_check(furi_hal_bt_extra_beacon_start());
+        bt_coex_switch(bt_model, CoexOwnerApp, &bt_model->config, bt_model->coex.data_len);
+    }
+}
+
+/**
+ * @brief      Start the configured beacon, after the start offset if any.
+ * @details    The worker doesn't sleep here: it keeps waiting on its flags with the start as
+ *             timeout, see bt_worker_start_due().
+*/
+static void bt_sched_start(uint32_t delay_ms, void* context) {
+    BtBeacon* bt_model = context;
+    bt_model->start_pending = delay_ms > 0;
+    if(bt_model->start_pending) {
+        bt_model->start_due = furi_get_tick() + furi_ms_to_ticks(delay_ms);
+    } else {
+        furi_check(furi_hal_bt_extra_beacon_start());
+    }
+}
+
+static void bt_sched_timer(uint32_t ms, void* context) {
+    BtBeacon* bt_model = context;
+    furi_timer_start(bt_model->timer_reset_beacon, furi_ms_to_ticks(ms));
+}
+
+/**
+ * @brief      Clock and radio of the schedule: the extra beacon, the random pool and the reset
+ *             timer, whose ThreadCommStopCmd moves the schedule on.
+ * @param      bt_model  The BtBeacon model.
+ * @return     the AdvSchedHal
+*/
+static AdvSchedHal bt_sched_hal(BtBeacon* bt_model) {
+    return (AdvSchedHal){
+        .random_below = bt_sched_random_below,
+        .set_interval = bt_sched_set_interval,
+        .start = bt_sched_start,
+        .timer = bt_sched_timer,
+        .context = bt_model,
+    };
+}
+
+/**
+ * @brief      Move to the next step of the adaptive schedule.
+ * @details    Only the advertising interval is reconfigured, the data stays the same.
+ * @param      bt_model  The BtBeacon model.
+ * @return     false if the schedule is over
+*/
+static bool bt_worker_schedule_next(BtBeacon* bt_model) {
+    if(!furi_hal_bt_extra_beacon_is_active()) {
+        bt_model->sched.step = 0;
+        return false;
+    }
+    AdvSchedConfig config;
+    bt_sched_config(bt_model, &config);
+    const AdvSchedHal hal = bt_sched_hal(bt_model);
+    if(!adv_sched_next(&bt_model->sched, &config, &hal)) {
+        return false;
+    }
+    FURI_LOG_D(
+        BT_TAG,
+        "Schedule step %u: %u-%ums up to %lums",
+        bt_model->sched.step,
+        bt_model->sched.min_interval_ms,
+        bt_model->sched.max_interval_ms,
+        bt_model->sched.elapsed_ms);
+    return true;
+}
+
+/**
+ * @brief      Copy the radio settings of the selected profile into the beacon config.
+ * @param      bt_model  The BtBeacon model.
+ * @return     true if the config changed
+*/
+static bool bt_worker_apply_profile(BtBeacon* bt_model) {
+    const RadioProfile* profile = &bt_model->profiles[bt_model->profile_idx];
+    const uint8_t power_idx = profile->tx_power_idx == TX_POWER_AUTO ? bt_model->auto_power_idx :
+                                                                       profile->tx_power_idx;
+    const GapAdvPowerLevel power = tx_power_values[power_idx];
+    const GapAdvChannelMap channels = channels_values[profile->channels_idx];
+    const bool changed = bt_model->config.adv_power_level != power ||
+                         bt_model->config.adv_channel_map != channels;
+    bt_model->config.adv_power_level = power;
+    bt_model->config.adv_channel_map = channels;
+    return changed;
+}
+
+/**
+ * @brief      Auto TX power, step up when the same press is repeated quickly.
+ * @details    A quick repeat is taken as a missed delivery. After a long quiet time the
+ *             level steps back down, so the learned level follows the receiver.
+ * @param      bt_model  The BtBeacon model.
+*/
+static void bt_worker_auto_power(BtBeacon* bt_model) {
+    if(bt_model->profiles[bt_model->profile_idx].tx_power_idx != TX_POWER_AUTO) {
+        return;
+    }
+    const uint32_t now = furi_get_tick();
+    const uint32_t gap = now - bt_model->last_press_tick;
+    const bool repeat = bt_model->last_press_button == bt_model->button_idx &&
+                        bt_model->last_press_event == bt_model->event_type;
+    if(repeat && bt_model->last_press_tick && gap < furi_ms_to_ticks(AUTO_POWER_REPEAT) &&
+       bt_model->auto_power_idx < COUNT_OF(tx_power_values) - 1) {
+        bt_model->auto_power_idx++;
+        FURI_LOG_I(BT_TAG, "Auto power up: level %u", bt_model->auto_power_idx);
+    } else if(
+        gap > furi_ms_to_ticks(AUTO_POWER_SETTLE) &&
+        bt_model->auto_power_idx > TX_POWER_AUTO + 1) {
+        bt_model->auto_power_idx--;
+        FURI_LOG_I(BT_TAG, "Auto power down: level %u", bt_model->auto_power_idx);
+    }
+    bt_model->last_press_tick = now;
+    bt_model->last_press_button = bt_model->button_idx;
+    bt_model->last_press_event = bt_model->event_type;
+}
+
+/**
+ * @brief      Refresh the decoded view of the packet on air.
+ * @details    Decoded here once per packet, the draw callback and the CLI only read the text.
+ * @param      bt_model  The BtBeacon model.
+ * @param      packet    The advertising data just set.
+ * @param      size      Its size.
+*/
+static void bt_worker_inspect(BtBeacon* bt_model, const uint8_t* packet, uint8_t size) {
+    furi_check(furi_mutex_acquire(bt_model->worker_mutex, FuriWaitForever) == FuriStatusOk);
+    if(adv_inspect_update(&bt_model->inspect, packet, size) &&
+       bt_model->inspect_top >= bt_model->inspect.line_count) {
+        bt_model->inspect_top = 0;
+    }
+    furi_check(furi_mutex_release(bt_model->worker_mutex) == FuriStatusOk);
+}
+
+/**
+ * @brief      Whether the beacon that was running when the app started goes back on air between
+ *             events.
+ * @details    It has priority over the sensor broadcast, which then stays off air.
+ * @param      bt_model  The BtBeacon model.
+ * @return     true with the coexistence mode on and a beacon found at start
+*/
+static bool bt_coex_restores_prev(const BtBeacon* bt_model) {
+    return bt_model->coex_enb && bt_model->prev_exists && bt_model->prev_active;
+}
+
+/**
+ * @brief      Take the beacon off air once an event is over.
+ * @details    With the coexistence mode on, the beacon that was running when the app started is
+ *             put back right away instead of at exit.
+ * @param      bt_model  The BtBeacon model.
+*/
+static void bt_worker_beacon_idle(BtBeacon* bt_model) {
+    bt_model->start_pending = false;
+    if(bt_coex_restores_prev(bt_model) && bt_model->coex.owner == CoexOwnerPrev) {
+        // Already back on air, e.g. suspended between events
+        return;
+    }
+    if(furi_hal_bt_extra_beacon_is_active()) {
+        furi_check(furi_hal_bt_extra_beacon_stop());
+    }
+    if(bt_coex_restores_prev(bt_model)) {
+        furi_check(furi_hal_bt_extra_beacon_set_config(&bt_model->prev_config));
+        furi_check(
+            furi_hal_bt_extra_beacon_set_data(bt_model->prev_data, bt_model->prev_data_len));
+        furi_check(furi_hal_bt_extra_beacon_start());
+        bt_coex_switch(bt_model, CoexOwnerPrev, &bt_model->prev_config, bt_model->prev_data_len);
+        bt_model->coex.restores++;
+    } else {
+        bt_coex_switch(bt_model, CoexOwnerNone, NULL, 0);
+    }
+}
+
+/**
+ * @brief      Start the beacon whose start offset is over.
+ * @param      bt_model  The BtBeacon model.
+ * @param      timeout   The flag wait timeout in ticks, lowered to the pending start.
+ * @return     true if the beacon was started
+*/
+static bool bt_worker_start_due(BtBeacon* bt_model, uint32_t* timeout) {
+    if(!bt_model->start_pending) {
+        return false;
+    }
+    const int32_t delta = (int32_t)(bt_model->start_due - furi_get_tick());
+    if(delta > 0) {
+        *timeout = MIN(*timeout, (uint32_t)delta);
+        return false;
+    }
+    bt_model->start_pending = false;
+    furi_check(furi_hal_bt_extra_beacon_start());
+    return true;
+}
+
+/**
+ * @brief      Put a packet on air.
+ * @details    If the beacon is already running with the current config only the data is swapped,
+ *             otherwise the beacon is (re)configured and started.
+ * @param      bt_model  The BtBeacon model.
+ * @param      restart   true to stop and reconfigure the beacon even if it's active.
+*/
+static void bt_worker_put_on_air(
+    BtBeacon* bt_model,
+    const uint8_t* packet,
+    uint8_t size,
+    bool restart) {
+    bt_model->status = BEACON_BUSY;
+    const bool active = furi_hal_bt_extra_beacon_is_active();
+    // The sensor beacon runs with a slow interval, reconfigure for events
+    // New data always starts from the fastest step of the schedule
+    // A beacon of another app has its own config
+    restart = restart || bt_model->sensor_on_air || bt_model->sched.step > 0 ||
+              bt_model->coex.owner == CoexOwnerPrev;
+    restart = bt_worker_apply_profile(bt_model) || restart;
+    bt_model->sensor_on_air = false;
+    if(active && restart) {
+        furi_check(furi_hal_bt_extra_beacon_stop());
+    }
+    const bool start = !active || restart;
+    AdvSchedConfig config;
+    bt_sched_config(bt_model, &config);
+    const AdvSchedHal hal = bt_sched_hal(bt_model);
+    adv_sched_begin(&bt_model->sched, &config, &hal, start);
+    bt_schedule_log(bt_model, &config);
+    if(start) {
+        furi_check(furi_hal_bt_extra_beacon_set_config(&bt_model->config));
+    }
+    furi_check(furi_hal_bt_extra_beacon_set_data(packet, size));
+    bt_worker_inspect(bt_model, packet, size);
+    bt_coex_switch(bt_model, CoexOwnerApp, &bt_model->config, size);
+    // The schedule window starts once the beacon is on, after the start offset
+    adv_sched_start(&bt_model->sched, &config, &hal, start);
+}
+
+/**
+ * @brief      Build a packet from the model and put it on air.
+ * @param      bt_model  The BtBeacon model.
+ * @param      restart   true to stop and reconfigure the beacon even if it's active.
+ * @return     false if the packet could not be built, nothing was sent
+*/
+static bool bt_worker_transmit(BtBeacon* bt_model, bool restart) {
+    uint8_t size;
+    uint8_t* packet;
+
+    if(!make_packet(bt_model, &size, &packet)) {
+        return false;
+    }
+    bt_worker_put_on_air(bt_model, packet, size, restart);
+    ATRACK_FREE(packet);
+    return true;
+}
+
+/**
+ * @brief      Add the packet just put on air to the transmission log.
+ * @details    Only a copy to the RAM ring, the SD card is written by the flusher thread.
+ * @param      bt_model  The BtBeacon model.
+ * @param      kind      The BtPacketKind.
+ * @param      button    The BTHome button index.
+ * @param      event     The BTHome event.
+ * @param      ticks     The latency from the request, 0 if not measured.
+*/
+static void bt_worker_log(
+    BtBeacon* bt_model,
+    uint8_t kind,
+    uint8_t button,
+    uint8_t event,
+    uint32_t ticks) {
+    const TxLogRecord record = {
+        .timestamp = furi_hal_rtc_get_timestamp(),
+        .latency_ms = MIN(ticks * 1000 / furi_kernel_get_tick_frequency(), UINT16_MAX),
+        .kind = kind,
+        .button = button,
+        .event = event,
+        .profile = bt_model->profile_idx,
+        .packet_id = bt_model->cnt,
+    };
+    tx_log_append(bt_model->tx_log, &record);
+}
+
+/**
+ * @brief      Put the last sensor readings on air.
+ * @details    When the sensor beacon is already running only the data is swapped, so updates
+ *             don't stop and restart the advertising.
+ * @param      bt_model  The BtBeacon model.
+*/
+static void bt_worker_sensor_on_air(BtBeacon* bt_model) {
+    uint8_t packet[EXTRA_BEACON_MAX_DATA_SIZE];
+    const BtPacketPayload payload = {
+        .kind = BtPacketSensor,
+        .sensor = &bt_model->sensor_sent,
+        .uptime = bt_model->sensor_mode == SensorModeUptime,
+    };
+    uint8_t size = bt_encode_packet(bt_model, &payload, bt_next_packet_id(bt_model), packet, NULL);
+    if(size == 0) {
+        return;
+    }
+
+    if(bt_worker_apply_profile(bt_model)) {
+        // Radio settings changed in the config, restart with them
+        bt_model->sensor_on_air = false;
+    }
+    const bool active = furi_hal_bt_extra_beacon_is_active();
+    if(!active || !bt_model->sensor_on_air) {
+        GapExtraBeaconConfig config = bt_model->config;
+        config.min_adv_interval_ms = SENSOR_ADV_INTERVAL;
+        config.max_adv_interval_ms = SENSOR_ADV_INTERVAL * 1.5;
+        if(active) {
+            furi_check(furi_hal_bt_extra_beacon_stop());
+        }
+        furi_check(furi_hal_bt_extra_beacon_set_config(&config));
+        furi_check(furi_hal_bt_extra_beacon_set_data(packet, size));
+        furi_check(furi_hal_bt_extra_beacon_start());
+        bt_coex_switch(bt_model, CoexOwnerApp, &config, size);
+        // Started right away, an event start still pending would start it twice
+        bt_model->start_pending = false;
+        bt_model->sensor_on_air = true;
+    } else {
+        furi_check(furi_hal_bt_extra_beacon_set_data(packet, size));
+    }
+    bt_worker_inspect(bt_model, packet, size);
+    bt_worker_log(bt_model, BtPacketSensor, 0, 0, 0);
+}
+
+/**
+ * @brief      Rotate the resolvable private address.
+ * @details    Called only when no event is on air, a running sensor broadcast moves to the
+ *             new address right away.
+ * @param      bt_model  The BtBeacon model.
+*/
+static void bt_worker_rpa_rotate(BtBeacon* bt_model) {
+    bt_model->rpa_pending = false;
+    if(bt_model->mac_mode != MacModeRpa) {
+        return;
+    }
+    furi_check(furi_mutex_acquire(bt_model->worker_mutex, FuriWaitForever) == FuriStatusOk);
+    bt_set_address(bt_model);
+    furi_check(furi_mutex_release(bt_model->worker_mutex) == FuriStatusOk);
+    if(bt_model->sensor_on_air && furi_hal_bt_extra_beacon_is_active()) {
+        bt_model->sensor_on_air = false;
+        bt_worker_sensor_on_air(bt_model);
+    }
+}
+
+/**
+ * @brief      Refresh the sensor readings, the beacon is updated only out of the deadbands.
+ * @param      bt_model  The BtBeacon model.
+*/
+static void bt_worker_sensor(BtBeacon* bt_model) {
+    if(bt_model->sensor_mode == SensorModeOff) {
+        return;
+    }
+
+    BtSensorReadings now = {
+        .battery = furi_hal_power_get_pct(),
+        .temperature =
+            furi_hal_power_get_battery_temperature(FuriHalPowerICFuelGauge) * 100.0f,
+        .voltage = furi_hal_power_get_battery_voltage(FuriHalPowerICFuelGauge) * 1000.0f,
+        .uptime = furi_get_tick() / furi_kernel_get_tick_frequency(),
+    };
+    const BtSensorReadings* last = &bt_model->sensor_sent;
+    const bool changed =
+        !bt_model->sensor_valid || abs(now.battery - last->battery) >= SENSOR_DB_BATTERY ||
+        abs(now.temperature - last->temperature) >= SENSOR_DB_TEMPERATURE ||
+        abs(now.voltage - last->voltage) >= SENSOR_DB_VOLTAGE ||
+        (bt_model->sensor_mode == SensorModeUptime &&
+         now.uptime - last->uptime >= SENSOR_DB_UPTIME);
+    if(!changed) {
+        bt_model->sensor_skipped++;
+        return;
+    }
+
+    bt_model->sensor_sent = now;
+    bt_model->sensor_valid = true;
+    bt_model->sensor_updates++;
+    FURI_LOG_D(
+        BT_TAG,
+        "Sensor update %lu (%lu skipped)",
+        bt_model->sensor_updates,
+        bt_model->sensor_skipped);
+    // While an event is on air the new readings go out once it ends, the beacon of the other
+    // app keeps the air between events
+    if(bt_model->status != BEACON_BUSY && !bt_coex_restores_prev(bt_model)) {
+        bt_worker_sensor_on_air(bt_model);
+    }
+}
+
+/**
+ * @brief      Start the Sub-GHz key of the button of the last event, if any.
+ * @details    Runs after the BLE packet is on air, the frames go out in the background and the
+ *             worker polls their end.
+ * @param      bt_model  The BtBeacon model.
+*/
+static void bt_worker_subghz_mirror(BtBeacon* bt_model) {
+    if(!bt_model->subghz_mirror_enb) {
+        return;
+    }
+    const SubghzMirrorKey* key = subghz_mirror_find(bt_model->subghz, bt_model->button_idx);
+    if(key) {
+        subghz_mirror_send(bt_model->subghz, key);
+    }
+}
+
+/**
+ * @brief      Account the latency of a press.
+ * @param      stats  The latency stats.
+ * @param      since  The tick the press was requested at.
+ * @return     the latency in ticks
+*/
+static uint32_t bt_latency_add(BtLatencyStats* stats, uint32_t since) {
+    const uint32_t ticks = furi_get_tick() - since;
+    stats->min = stats->count ? MIN(stats->min, ticks) : ticks;
+    stats->max = MAX(stats->max, ticks);
+    stats->sum += ticks;
+    stats->count++;
+    return ticks;
+}
+
+/**
+ * @brief      Run the commands queued by the UART bridge and the CLI.
+ * @param      app  The App object.
+*/
+static void bt_worker_ext_cmd(App* app) {
+    BtBeacon* bt_model = view_get_model(app->view_bt);
+    Cmd cmd;
+    while(furi_message_queue_get(app->cmd_queue, &cmd, 0) == FuriStatusOk) {
+        switch(cmd.type) {
+        case CmdPress:
+            bt_model->button_idx = cmd.press.button;
+            bt_model->event_type = cmd.press.event;
+            bt_model->packet_kind = BtPacketButton;
+            bt_worker_auto_power(bt_model);
+            if(bt_worker_transmit(bt_model, true)) {
+                bt_worker_log(
+                    bt_model,
+                    BtPacketButton,
+                    cmd.press.button,
+                    cmd.press.event,
+                    bt_latency_add(&bt_model->latency, cmd.tick));
+            }
+            bt_worker_subghz_mirror(bt_model);
+            break;
+        case CmdSensor:
+            // Host readings replace the Flipper ones until the next refresh out of deadband
+            if(cmd.sensor.mask & CmdSensorBattery) {
+                bt_model->sensor_sent.battery = cmd.sensor.battery;
+            }
+            if(cmd.sensor.mask & CmdSensorTemperature) {
+                bt_model->sensor_sent.temperature = cmd.sensor.temperature;
+            }
+            if(cmd.sensor.mask & CmdSensorVoltage) {
+                bt_model->sensor_sent.voltage = cmd.sensor.voltage;
+            }
+            bt_model->packet_kind = BtPacketSensor;
+            if(bt_worker_transmit(bt_model, true)) {
+                bt_worker_log(bt_model, BtPacketSensor, 0, 0, furi_get_tick() - cmd.tick);
+            }
+            break;
+        case CmdProfile:
+            bt_model->profile_idx = cmd.profile.index;
+            bt_model->auto_power_idx = TX_POWER_AUTO + 1;
+            FURI_LOG_I(BT_TAG, "Profile: %s", profile_names[bt_model->profile_idx]);
+            break;
+        case CmdName:
+            // Runtime only, the config file keeps its name. The draw callback reads it.
+            furi_check(
+                furi_mutex_acquire(bt_model->worker_mutex, FuriWaitForever) == FuriStatusOk);
+            futils_copy_str(
+                bt_model->device_name,
+                cmd.name,
+                MAX_NAME_LENGHT + 1,
+                "bt_worker_ext_cmd",
+                "bt_model->device_name");
+            bt_model->device_name_len = strlen(bt_model->device_name);
+            furi_check(furi_mutex_release(bt_model->worker_mutex) == FuriStatusOk);
+            bt_model->name_presses = 0;
+            bt_macro_build(app);
+            break;
+        case CmdInterval:
+            bt_model->beacon_period = cmd.ms;
+            break;
+        case CmdDuration:
+            bt_model->beacon_duration = cmd.ms;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief      Send the macro step due now, if any.
+ * @param      bt_model  The BtBeacon model.
+*/
+static void bt_worker_macro(BtBeacon* bt_model) {
+    MacroStep* step = macro_next(bt_model->macro, furi_get_tick());
+    if(step && step->size) {
+        step->packet[step->id_offset] = bt_next_packet_id(bt_model);
+        bt_worker_put_on_air(bt_model, step->packet, step->size, false);
+        bt_worker_log(bt_model, BtPacketButton, step->button, step->event, 0);
+    }
+}
+
+/**
+ * @brief      Send the accumulated dimmer steps, rate limited to what receivers can catch.
+ * @details    Steps coming in faster than DIMMER_MIN_ADV_EVENTS advertising intervals are merged
+ *             into the next update instead of being queued.
+ * @param      bt_model  The BtBeacon model.
+*/
+static void bt_worker_dim(BtBeacon* bt_model) {
+    const uint32_t min_gap = bt_model->beacon_period * DIMMER_MIN_ADV_EVENTS;
+    const uint32_t elapsed = furi_get_tick() - bt_model->dim_last_tick;
+    if(elapsed < min_gap) {
+        if(!furi_timer_is_running(bt_model->timer_dim)) {
+            furi_timer_start(bt_model->timer_dim, min_gap - elapsed);
+        }
+        return;
+    }
+
+    int16_t steps;
+    FURI_CRITICAL_ENTER();
+    steps = CLAMP(bt_model->dim_acc, DIMMER_MAX_STEPS, -DIMMER_MAX_STEPS);
+    bt_model->dim_acc -= steps;
+    FURI_CRITICAL_EXIT();
+    if(steps == 0) {
+        return;
+    }
+
+    bt_model->packet_kind = BtPacketDimmer;
+    bt_model->dim_event = steps > 0 ? BTHomeDimmerRotateRight : BTHomeDimmerRotateLeft;
+    bt_model->dim_steps = steps > 0 ? steps : -steps;
+    FURI_LOG_I(BT_TAG, "Sending dimmer %d steps", steps);
+    if(bt_worker_transmit(bt_model, false)) {
+        bt_worker_log(bt_model, BtPacketDimmer, 0, bt_model->dim_event, 0);
+    }
+    bt_model->dim_last_tick = furi_get_tick();
+
+    if(bt_model->dim_acc != 0) {
+        furi_timer_start(bt_model->timer_dim, min_gap);
+    }
+}
+
 int32_t bt_comm_worker(void* context) {
     App* app = (App*)context;
     BtBeacon* bt_model = view_get_model(app->view_bt);
-    bool run = true;
+    bool suspended = true;
 
-    while(run) {
+    while(true) {
+        // Sleep until the next macro step at most
+        uint32_t timeout = FuriWaitForever;
+        uint32_t due;
+        if(macro_get_due(bt_model->macro, &due)) {
+            int32_t delta = (int32_t)(due - furi_get_tick());
+            timeout = delta > 0 ? (uint32_t)delta : 0;
+        }
+        // Poll the end of the Sub-GHz frames meanwhile
+        if(subghz_mirror_poll(bt_model->subghz)) {
+            timeout = MIN(timeout, furi_ms_to_ticks(SUBGHZ_MIRROR_POLL));
+        }
+        // Or until the start offset of the event is over, a start already due is done here
+        bt_worker_start_due(bt_model, &timeout);
         uint32_t events = furi_thread_flags_wait(
-            ThreadCommStop | ThreadCommStopCmd | ThreadCommSendCmd,
+            ThreadCommStop | ThreadCommStopCmd | ThreadCommSendCmd | ThreadCommResume |
+                ThreadCommSuspend | ThreadCommDimCmd | ThreadCommMacroCmd | ThreadCommSensorCmd |
+                ThreadCommRpaCmd | ThreadCommExtCmd,
             FuriFlagWaitAny,
-            FuriWaitForever);
+            timeout);
+        if(events & FuriFlagError) {
+            // Timeout, a macro step, a beacon start or a Sub-GHz poll is due
+            events = 0;
+        }
+        // Several requests may be pending at once, handle all of them
         if(events & ThreadCommStop) {
-            run = false;
             FURI_LOG_I(TAG, "Thread event: Stop command request");
-
-        } else if(events & ThreadCommStopCmd) {
+            break;
+        }
+        if(events & (ThreadCommSuspend | ThreadCommResume)) {
+            // Both flags may be pending after a quick exit/enter, the view state is the truth
+            suspended = !app->bt_view_active;
+            if(suspended) {
+                bt_model->status = BEACON_INACTIVE;
+                furi_timer_stop(bt_model->timer_dim);
+                bt_model->dim_acc = 0;
+                macro_stop(bt_model->macro);
+                bt_model->sensor_on_air = false;
+                bt_model->sensor_valid = false;
+                bt_worker_beacon_idle(bt_model);
+                subghz_mirror_close(bt_model->subghz);
+            } else if(bt_model->subghz_mirror_enb) {
+                // The setting only changes while suspended, prepare the CC1101 once here
+                subghz_mirror_open(bt_model->subghz);
+            }
+            FURI_LOG_I(TAG, "Thread event: %s", suspended ? "Suspend" : "Resume");
+        }
+        if((events & ThreadCommStopCmd) && !bt_worker_schedule_next(bt_model)) {
+            bt_schedule_report(bt_model);
             bt_model->status = BEACON_INACTIVE;
             FURI_LOG_I(BT_TAG, "Resetting Beacon...");
-            if(furi_hal_bt_extra_beacon_is_active()) {
-                furi_check(furi_hal_bt_extra_beacon_stop());
+            if(bt_model->sensor_mode != SensorModeOff && bt_model->sensor_valid && !suspended &&
+               !bt_coex_restores_prev(bt_model)) {
+                // Go back to the sensor broadcast instead of stopping
+                bt_worker_sensor_on_air(bt_model);
+            } else {
+                bt_worker_beacon_idle(bt_model);
             }
             FURI_LOG_I(BT_TAG, "Resetting Beacon done.");
-        } else if(events & ThreadCommSendCmd) {
-            bt_model->status = BEACON_BUSY;
+        }
+        if(events & ThreadCommRpaCmd) {
+            bt_model->rpa_pending = true;
+        }
+        // Never change the address of an in-flight event, wait for its end
+        if(bt_model->rpa_pending && bt_model->status != BEACON_BUSY && !suspended) {
+            bt_worker_rpa_rotate(bt_model);
+        }
+        if(suspended && (events & (ThreadCommSendCmd | ThreadCommDimCmd | ThreadCommMacroCmd |
+                                   ThreadCommSensorCmd | ThreadCommExtCmd))) {
+            FURI_LOG_W(BT_TAG, "Worker suspended, send request dropped");
+            Cmd cmd;
+            while(furi_message_queue_get(app->cmd_queue, &cmd, 0) == FuriStatusOk) {
+            }
+            continue;
+        }
+        if(events & ThreadCommSendCmd) {
+            // Opened here, the tracker only accounts the allocations of the opening thread
+            atrack_op_begin(AtrackOpPress);
             FURI_LOG_I(BT_TAG, "Sending BTHome data...");
-            if(furi_hal_bt_extra_beacon_is_active()) {
-                furi_check(furi_hal_bt_extra_beacon_stop());
+            bt_model->packet_kind = BtPacketButton;
+            bt_worker_auto_power(bt_model);
+            if(bt_worker_transmit(bt_model, true)) {
+                bt_worker_log(
+                    bt_model,
+                    BtPacketButton,
+                    bt_model->button_idx,
+                    bt_model->event_type,
+                    bt_latency_add(&bt_model->latency, bt_model->press_tick));
             }
-
-            uint8_t size;
-            uint8_t* packet;
-            GapExtraBeaconConfig* config = &bt_model->config;
-
-            furi_check(furi_hal_bt_extra_beacon_set_config(config));
-            if(make_packet(bt_model, &size, &packet)) {
-                furi_check(furi_hal_bt_extra_beacon_set_data(packet, size));
-                furi_check(furi_hal_bt_extra_beacon_start());
-                furi_timer_start(bt_model->timer_reset_beacon, bt_model->beacon_duration);
-                free(packet);
+            atrack_op_end(AtrackOpPress);
+            bt_worker_subghz_mirror(bt_model);
+        }
+        if(events & ThreadCommDimCmd) {
+            bt_worker_dim(bt_model);
+        }
+        if(events & ThreadCommMacroCmd) {
+            if(bt_model->macro->running) {
+                FURI_LOG_I(BT_TAG, "Macro stopped");
+                macro_stop(bt_model->macro);
+            } else {
+                FURI_LOG_I(BT_TAG, "Macro started");
+                macro_start(bt_model->macro, furi_get_tick());
             }
         }
+        if(events & ThreadCommSensorCmd) {
+            bt_worker_sensor(bt_model);
+        }
+        if(events & ThreadCommExtCmd) {
+            bt_worker_ext_cmd(app);
+        }
+        bt_worker_macro(bt_model);
     }
+    subghz_mirror_close(bt_model->subghz);
     FURI_LOG_I(TAG, "Thread event: Stopping...");
     return 0;
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include "app.h"
+#include "bthome.h"
 #include <furi.h>
 #include <gui/modules/submenu.h>
 #include <gui/modules/text_box.h>
@@ -11,17 +12,59 @@
 
 #define BT_TAG "BT"
 
+#define BT_HOME_BUTTON_COUNT 5
+#define BT_INSPECT_ROWS      5 // Decoded lines on the packet page
+
 typedef enum {
-    BTHomeShortPress = 0x01,
-    BTHomeLongPress = 0x04,
-} BTHomeEventType;
+    BTHomeButtonOk,
+    BTHomeButtonUp,
+    BTHomeButtonDown,
+    BTHomeButtonLeft,
+    BTHomeButtonRight,
+} BTHomeButtonIndex;
+
+typedef struct {
+    uint8_t kind; // BtPacketKind
+    uint8_t button;
+    uint8_t event; // BTHomeEventType, BTHomeDimmerEvent for the dimmer
+    uint8_t steps; // Dimmer only
+    const BtSensorReadings* sensor; // Sensor only
+    bool uptime; // Sensor only, include the uptime
+} BtPacketPayload;
 
+void bt_macro_build(App* app);
 void bt_enter_callback(void* context);
 void bt_exit_callback(void* context);
 void bt_draw_callback(Canvas* canvas, void* model);
 bool bt_input_callback(InputEvent* event, void* context);
 void timer_beacon_reset_callback(void* context);
+void timer_dim_callback(void* context);
+void timer_sensor_callback(void* context);
+void view_bt_timer_callback(void* context);
+int8_t bt_button_index(InputKey key);
+void bt_send_event(App* app, uint8_t button, uint8_t event);
+bool bt_cmd_line_callback(char* line, const char** error, void* context);
+void bt_uart_bridge_update(App* app);
+void bt_gesture_configure(App* app);
+void bt_gesture_rearm(App* app);
+void bt_gesture_timer_callback(void* context);
+uint8_t bt_encode_packet(
+    const BtBeacon* bt_model,
+    const BtPacketPayload* payload,
+    uint8_t packet_id,
+    uint8_t* packet,
+    uint8_t* id_offset);
+uint16_t bt_airtime_us(uint8_t size);
+void bt_name_policy_sizes(const BtBeacon* bt_model, uint8_t sizes[NAME_POLICY_COUNT]);
+void bt_sched_config(const BtBeacon* bt_model, AdvSchedConfig* config);
 bool make_packet(BtBeacon* bt_model, uint8_t* _size, uint8_t** _packet);
+void timer_rpa_callback(void* context);
+void bt_set_address(BtBeacon* bt_model);
+bool bt_address_is_dynamic(const BtBeacon* bt_model);
 void randomize_mac(uint8_t address[EXTRA_BEACON_MAC_ADDR_SIZE]);
-void pretty_print_mac(FuriString* mac_str, uint8_t address[EXTRA_BEACON_MAC_ADDR_SIZE]);
+void pretty_print_mac(
+    FuriString* mac_str,
+    const uint8_t address[EXTRA_BEACON_MAC_ADDR_SIZE],
+    size_t len);
+bool parse_mac(const char* str, uint8_t address[EXTRA_BEACON_MAC_ADDR_SIZE]);
 int32_t bt_comm_worker(void* context);
@@ -0,0 +1,400 @@
+#include "bt_cli.h"
+#include "bt.h"
+#include "libs/furi_utils.h"
+#include "fleet_sim.h"
+#include <cli/cli.h>
+#include <storage/storage.h>
+
+#define BT_CLI_CONF_SIZE        1024 // As read by load_settings
+#define BT_CLI_RNG_DRAWS        1000
+#define BT_CLI_FLEET_SPREAD     1000 // ms, default time over which the fleet presses
+#define BT_CLI_JSON_KB          4 // Default size of the JSON benchmark document
+#define BT_CLI_JSON_KB_MAX      8 // The tokens take about 3 times the document
+// Benchmark item with separators inside a string
+#define BT_CLI_JSON_ITEM        "{\"name\":\"a, {b}: [c]\",\"value\":-12.5,\"list\":[1,2,3]}"
+#define BT_CLI_JSON_ITEM_TOKENS 10
+
+extern const char* profile_names[PROFILE_COUNT];
+extern const char* tx_power_names[6];
+extern const char* channels_names[4];
+extern const GapAdvChannelMap channels_values[4];
+extern const char* mac_mode_names[4];
+extern const char* adv_schedule_names[2];
+extern const char* adv_jitter_names[4];
+extern const char* name_policy_names[NAME_POLICY_COUNT];
+
+static void bt_cli_print_usage(void) {
+    printf("Usage: " BT_CLI_COMMAND " <command>\r\n");
+    printf("  send <button> [event]   queue a button event (short, double, long, ...)\r\n");
+    printf("  sensor temp=<C> batt=<%%> volt=<V>\r\n");
+    printf("  profile <name|index>\r\n");
+    printf("  name <device name>\r\n");
+    printf("  interval <ms>\r\n");
+    printf("  duration <ms>\r\n");
+    printf("  stats [reset]           press to radio latency\r\n");
+    printf("  config [json]           current settings, or the config file\r\n");
+    printf("  packet                  decoded packet on air\r\n");
+    printf("  airtime                 button packet size with every name policy\r\n");
+    printf("  rng                     random pool usage and cost per draw\r\n");
+    printf("  fleet [devices] [ms]    simulate remotes pressing within ms, current settings\r\n");
+    printf("  json [kb]               time the JSON pretty printer on a generated document\r\n");
+    printf("The remote view must be open, settings changed here are not saved.\r\n");
+}
+
+static void bt_cli_print_stats(BtBeacon* bt_model, bool reset) {
+    const BtLatencyStats stats = bt_model->latency;
+    if(reset) {
+        memset(&bt_model->latency, 0, sizeof(BtLatencyStats));
+    }
+    const uint32_t freq = furi_kernel_get_tick_frequency();
+    printf("presses: %lu\r\n", stats.count);
+    if(stats.count) {
+        printf(
+            "latency ms: min %lu, avg %lu, max %lu\r\n",
+            stats.min * 1000 / freq,
+            stats.sum / stats.count * 1000 / freq,
+            stats.max * 1000 / freq);
+    }
+    printf(
+        "packet id: %u, %lu packets, %lu counter writes\r\n",
+        bt_model->cnt,
+        counter_store_get(bt_model->counter),
+        counter_store_writes(bt_model->counter));
+    const CoexStats* coex = &bt_model->coex;
+    const uint32_t air_total = coex->air_ms[CoexOwnerApp] + coex->air_ms[CoexOwnerPrev];
+    printf(
+        "keep other beacon: %s, %s, %lu restores\r\n",
+        bt_model->coex_enb ? "on" : "off",
+        bt_model->prev_active ? "other beacon found" : "no other beacon",
+        coex->restores);
+    printf(
+        "on air s: app %lu, other %lu; air time ms: app %lu, other %lu, app share %lu%%\r\n",
+        coex->on_air_ms[CoexOwnerApp] / 1000,
+        coex->on_air_ms[CoexOwnerPrev] / 1000,
+        coex->air_ms[CoexOwnerApp],
+        coex->air_ms[CoexOwnerPrev],
+        air_total ? coex->air_ms[CoexOwnerApp] * 100 / air_total : 0);
+}
+
+static void bt_cli_print_config(App* app, BtBeacon* bt_model) {
+    const RadioProfile* profile = &bt_model->profiles[bt_model->profile_idx];
+    // A remote name command rewrites it in the worker, under the mutex.
+    char name[MAX_NAME_LENGHT + 1];
+    furi_check(furi_mutex_acquire(bt_model->worker_mutex, FuriWaitForever) == FuriStatusOk);
+    futils_copy_str(name, bt_model->device_name, sizeof(name), "bt_cli_print_config", "name");
+    furi_check(furi_mutex_release(bt_model->worker_mutex) == FuriStatusOk);
+    printf("name: %s\r\n", name);
+    printf("name in packet: %s\r\n", name_policy_names[bt_model->name_policy_idx]);
+    printf(
+        "mac: %s (%s)\r\n",
+        furi_string_get_cstr(bt_model->mac_address_str),
+        mac_mode_names[bt_model->mac_mode]);
+    printf("interval: %u ms\r\n", bt_model->beacon_period);
+    printf("duration: %u ms\r\n", bt_model->beacon_duration);
+    printf("schedule: %s\r\n", adv_schedule_names[bt_model->adv_schedule]);
+    printf("send count: %u\r\n", bt_model->send_count);
+    printf(
+        "jitter: %s, last offset %u ms, interval %u-%u ms\r\n",
+        adv_jitter_names[bt_model->adv_jitter_idx],
+        bt_model->sched.offset_ms,
+        bt_model->config.min_adv_interval_ms,
+        bt_model->config.max_adv_interval_ms);
+    printf(
+        "profile: %s, power %s, channels %s\r\n",
+        profile_names[bt_model->profile_idx],
+        tx_power_names[profile->tx_power_idx],
+        channels_names[profile->channels_idx]);
+    printf("remote mode: %s\r\n", bt_model->remote_mode_enb ? "on" : "off");
+    printf(
+        "subghz mirror: %s, %u keys\r\n",
+        bt_model->subghz_mirror_enb ? "on" : "off",
+        bt_model->subghz->key_count);
+    printf("view: %s\r\n", app->bt_view_active ? "open" : "closed");
+}
+
+/**
+ * @brief      Print the decoded packet, copied under the worker mutex so it is consistent.
+*/
+static void bt_cli_print_packet(BtBeacon* bt_model) {
+    AdvInspect* inspect = ATRACK_MALLOC(sizeof(AdvInspect));
+    furi_check(furi_mutex_acquire(bt_model->worker_mutex, FuriWaitForever) == FuriStatusOk);
+    memcpy(inspect, &bt_model->inspect, sizeof(AdvInspect));
+    furi_check(furi_mutex_release(bt_model->worker_mutex) == FuriStatusOk);
+
+    if(inspect->size == 0) {
+        printf("nothing sent yet\r\n");
+    } else {
+        for(uint8_t i = 0; i < inspect->line_count; i++) {
+            printf("%s\r\n", inspect->lines[i]);
+        }
+        printf(
+            "%u bytes, %u AD, %u objects%s, decoded %lu times, %lu packet id updates\r\n",
+            inspect->size,
+            inspect->ad_count,
+            inspect->obj_count,
+            inspect->malformed ? ", malformed" : "",
+            inspect->decodes,
+            inspect->id_updates);
+    }
+    ATRACK_FREE(inspect);
+}
+
+/**
+ * @brief      Print the size and air time of the current button event with every name policy.
+ * @details    The air time is for one advertising event, on every enabled channel.
+*/
+static void bt_cli_print_airtime(BtBeacon* bt_model) {
+    uint8_t sizes[NAME_POLICY_COUNT];
+    bt_name_policy_sizes(bt_model, sizes);
+    const RadioProfile* profile = &bt_model->profiles[bt_model->profile_idx];
+    const uint8_t channels = __builtin_popcount(channels_values[profile->channels_idx]);
+    const uint32_t full_us = bt_airtime_us(sizes[NAME_POLICY_ALWAYS]) * channels;
+    for(uint8_t p = 0; p < NAME_POLICY_COUNT; p++) {
+        const uint32_t us = bt_airtime_us(sizes[p]) * channels;
+        printf(
+            "%c %-8s %2u bytes, %4lu us, saved %2lu%%\r\n",
+            p == bt_model->name_policy_idx ? '*' : ' ',
+            name_policy_names[p],
+            sizes[p],
+            us,
+            (full_us - us) * 100 / full_us);
+    }
+    printf(
+        "saved so far: %lu bytes, %lu us per channel and advertising event\r\n",
+        bt_model->name_saved_bytes,
+        bt_model->name_saved_bytes * 8);
+}
+
+/**
+ * @brief      Print the random pool counters and time draws from the pool and from the RNG.
+*/
+static void bt_cli_print_rng(void) {
+    volatile uint32_t sink = 0;
+    uint32_t start = DWT->CYCCNT;
+    for(uint32_t i = 0; i < BT_CLI_RNG_DRAWS; i++) {
+        sink += futils_random_below(EXTRA_BEACON_MAX_DATA_SIZE);
+    }
+    const uint32_t pool_cycles = DWT->CYCCNT - start;
+    start = DWT->CYCCNT;
+    for(uint32_t i = 0; i < BT_CLI_RNG_DRAWS; i++) {
+        sink += furi_hal_random_get() % EXTRA_BEACON_MAX_DATA_SIZE;
+    }
+    const uint32_t direct_cycles = DWT->CYCCNT - start;
+    UNUSED(sink);
+
+    uint32_t refills, misses;
+    futils_random_stats(&refills, &misses);
+    printf(
+        "cycles per draw: pool %lu, RNG %lu (%lu cycles/us)\r\n",
+        pool_cycles / BT_CLI_RNG_DRAWS,
+        direct_cycles / BT_CLI_RNG_DRAWS,
+        furi_hal_cortex_instructions_per_microsecond());
+    printf("refills: %lu, empty pool draws: %lu\r\n", refills, misses);
+}
+
+static void bt_cli_json_count(const char* data, size_t len, void* context) {
+    UNUSED(data);
+    *(size_t*)context += len;
+}
+
+/**
+ * @brief      Time the JSON pretty printer on a generated document, parsing included.
+ * @details    Both the streaming and the exact size buffer paths are timed, and their output
+ *             sizes must agree.
+ * @param      kb    The document size in KB, 0 for the default.
+*/
+static void bt_cli_print_json_bench(uint32_t kb) {
+    kb = kb ? MIN(kb, BT_CLI_JSON_KB_MAX) : BT_CLI_JSON_KB;
+    const uint32_t items = kb * 1024 / (strlen(BT_CLI_JSON_ITEM) + 1);
+    FuriString* doc = furi_string_alloc_set_str("{\"items\":[");
+    for(uint32_t i = 0; i < items; i++) {
+        furi_string_cat_str(doc, i ? "," BT_CLI_JSON_ITEM : BT_CLI_JSON_ITEM);
+    }
+    furi_string_cat_str(doc, "]}");
+    const char* json = furi_string_get_cstr(doc);
+    const uint32_t max_tokens = items * BT_CLI_JSON_ITEM_TOKENS + 3;
+
+    size_t streamed = 0;
+    uint32_t start = DWT->CYCCNT;
+    const bool valid = futils_json_pretty_stream(
+        json, max_tokens, FUTILS_TEXT_BOX_WIDTH, bt_cli_json_count, &streamed);
+    const uint32_t stream_cycles = DWT->CYCCNT - start;
+    start = DWT->CYCCNT;
+    char* text = futils_json_pretty(json, max_tokens, FUTILS_TEXT_BOX_WIDTH);
+    const uint32_t buffer_cycles = DWT->CYCCNT - start;
+
+    const uint32_t cycles_us = furi_hal_cortex_instructions_per_microsecond();
+    if(!valid || text == NULL) {
+        printf("ERR not enough memory for %lu tokens\r\n", max_tokens);
+    } else {
+        printf("document: %u bytes, %lu tokens\r\n", furi_string_size(doc), max_tokens);
+        printf(
+            "stream: %lu us, buffer: %lu us, %u bytes out\r\n",
+            stream_cycles / cycles_us,
+            buffer_cycles / cycles_us,
+            streamed);
+        printf("size check: %s\r\n", strlen(text) == streamed ? "ok" : "FAIL");
+    }
+    if(text) {
+        ATRACK_FREE(text);
+    }
+    furi_string_free(doc);
+}
+
+/**
+ * @brief      Simulate a fleet of remotes with the current advertising settings.
+ * @param      bt_model  The BtBeacon model.
+ * @param      devices   The fleet size, 0 for a sweep over sizes.
+ * @param      spread    ms over which the presses are spread.
+*/
+static void bt_cli_fleet(BtBeacon* bt_model, uint32_t devices, uint32_t spread) {
+    static const uint32_t sweep[] = {10, 50, 100, 500, 1000};
+    uint8_t sizes[NAME_POLICY_COUNT];
+    bt_name_policy_sizes(bt_model, sizes);
+    const RadioProfile* profile = &bt_model->profiles[bt_model->profile_idx];
+    FleetSimConfig config = {
+        .spread_ms = spread,
+        .channel_map = channels_values[profile->channels_idx],
+        .pdu_us = bt_airtime_us(sizes[bt_model->name_policy_idx]),
+        .seed = futils_random_u32(),
+    };
+    bt_sched_config(bt_model, &config.sched);
+    printf(
+        "interval %u ms, %s %u, %s, jitter %s, channels %s, PDU %u us, presses within %lu ms\r\n",
+        config.sched.period_ms,
+        config.sched.send_count ? "send count" : "duration ms",
+        config.sched.send_count ? config.sched.send_count : config.sched.duration_ms,
+        adv_schedule_names[bt_model->adv_schedule],
+        adv_jitter_names[bt_model->adv_jitter_idx],
+        channels_names[profile->channels_idx],
+        config.pdu_us,
+        config.spread_ms);
+    for(uint8_t i = 0; i < COUNT_OF(sweep); i++) {
+        config.devices = devices ? devices : sweep[i];
+        FleetSimResult result;
+        const uint32_t start = furi_get_tick();
+        if(!fleet_sim_run(&config, &result)) {
+            printf("ERR out of memory\r\n");
+            return;
+        }
+        printf(
+            "%5lu: delivered %3lu%%, collided %3lu%%, latency ms p50 %u p90 %u p99 %u, "
+            "%lu ms for %lu ms\r\n",
+            result.presses,
+            result.delivered * 100 / result.presses,
+            result.events ? result.collided * 100 / result.events : 0,
+            result.latency_p50,
+            result.latency_p90,
+            result.latency_p99,
+            furi_get_tick() - start,
+            result.sim_ms);
+        if(devices) {
+            break;
+        }
+    }
+}
+
+static void bt_cli_json_write(const char* data, size_t len, void* context) {
+    UNUSED(context);
+    for(size_t i = 0; i < len; i++) {
+        if(data[i] == '\n') {
+            printf("\r");
+        }
+        putchar(data[i]);
+    }
+}
+
+/**
+ * @brief      Print the config file, pretty printed while it's read out.
+*/
+static void bt_cli_print_config_file(void) {
+    char* conf = ATRACK_MALLOC(BT_CLI_CONF_SIZE);
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    size_t len = 0;
+    if(storage_file_open(file, BT_CONF_PATH, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        len = storage_file_read(file, conf, BT_CLI_CONF_SIZE - 1);
+    }
+    conf[len] = '\0';
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+
+    if(len == 0) {
+        printf("ERR no config file\r\n");
+    } else if(!futils_json_pretty_stream(
+                  conf, FUTILS_JSON_MAX_TOKENS, 0, bt_cli_json_write, NULL)) {
+        printf("ERR config file is not valid JSON\r\n");
+    } else {
+        printf("\r\n");
+    }
+    ATRACK_FREE(conf);
+}
+
+/**
+ * @brief      Handler of the bt_home CLI command, runs in the CLI thread.
+ * @details    Commands that change the beacon go through the same parser and queue as the UART
+ *             bridge, so they run in the comm worker of the app.
+*/
+static void bt_cli_callback(Cli* cli, FuriString* args, void* context) {
+    UNUSED(cli);
+    App* app = (App*)context;
+    BtBeacon* bt_model = view_get_model(app->view_bt);
+    char line[CMD_LINE_SIZE];
+
+    furi_string_trim(args, " \r\n\t");
+    if(furi_string_size(args) == 0) {
+        bt_cli_print_usage();
+        return;
+    }
+    if(furi_string_size(args) >= sizeof(line)) {
+        printf("ERR line too long\r\n");
+        return;
+    }
+    strcpy(line, furi_string_get_cstr(args));
+
+    if(strncasecmp(line, "stats", 5) == 0) {
+        bt_cli_print_stats(bt_model, strstr(line, "reset") != NULL);
+    } else if(strcasecmp(line, "config") == 0) {
+        bt_cli_print_config(app, bt_model);
+    } else if(strcasecmp(line, "config json") == 0) {
+        bt_cli_print_config_file();
+    } else if(strcasecmp(line, "packet") == 0) {
+        bt_cli_print_packet(bt_model);
+    } else if(strcasecmp(line, "airtime") == 0) {
+        bt_cli_print_airtime(bt_model);
+    } else if(strcasecmp(line, "rng") == 0) {
+        bt_cli_print_rng();
+    } else if(strncasecmp(line, "fleet", 5) == 0) {
+        char* end;
+        const uint32_t devices = strtoul(line + 5, &end, 10);
+        const uint32_t spread = strtoul(end, &end, 10);
+        bt_cli_fleet(bt_model, devices, spread ? spread : BT_CLI_FLEET_SPREAD);
+    } else if(strncasecmp(line, "json", 4) == 0) {
+        bt_cli_print_json_bench(strtoul(line + 4, NULL, 10));
+    } else {
+        const char* error = "rejected";
+        if(bt_cmd_line_callback(line, &error, app)) {
+            printf("OK\r\n");
+        } else {
+            printf("ERR %s\r\n", error);
+        }
+    }
+}
+
+/**
+ * @brief      Add the bt_home command to the Flipper CLI while the app runs.
+ * @param      app  The App object.
+*/
+void bt_cli_register(App* app) {
+    Cli* cli = furi_record_open(RECORD_CLI);
+    cli_add_command(cli, BT_CLI_COMMAND, CliCommandFlagParallelSafe, bt_cli_callback, app);
+    furi_record_close(RECORD_CLI);
+}
+
+void bt_cli_unregister(App* app) {
+    UNUSED(app);
+    Cli* cli = furi_record_open(RECORD_CLI);
+    cli_delete_command(cli, BT_CLI_COMMAND);
+    furi_record_close(RECORD_CLI);
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include "app.h"
+
+#define BT_CLI_COMMAND "bt_home"
+
+void bt_cli_register(App* app);
+void bt_cli_unregister(App* app);
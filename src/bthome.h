@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+
+// BTHome v2 protocol constants, see https://bthome.io/format/
+
+#define BTHOME_UUID_LO 0xD2
+#define BTHOME_UUID_HI 0xFC
+
+// Object IDs
+#define BTHOME_OBJ_PACKET_ID   0x00
+#define BTHOME_OBJ_BATTERY     0x01
+#define BTHOME_OBJ_TEMPERATURE 0x02
+#define BTHOME_OBJ_VOLTAGE     0x0C
+#define BTHOME_OBJ_COUNT       0x3E
+#define BTHOME_OBJ_BUTTON      0x3A
+#define BTHOME_OBJ_DIMMER      0x3C
+
+typedef enum {
+    BTHomeNoEvent = 0x00,
+    BTHomeShortPress = 0x01,
+    BTHomeDoublePress = 0x02,
+    BTHomeTriplePress = 0x03,
+    BTHomeLongPress = 0x04,
+    BTHomeLongDoublePress = 0x05,
+    BTHomeLongTriplePress = 0x06,
+} BTHomeEventType;
+
+typedef enum {
+    BTHomeDimmerNone = 0x00,
+    BTHomeDimmerRotateLeft = 0x01,
+    BTHomeDimmerRotateRight = 0x02,
+} BTHomeDimmerEvent;
@@ -0,0 +1,278 @@
+#include "command.h"
+#include "bthome.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+typedef struct {
+    const char* name;
+    uint8_t event;
+} CmdEventName;
+
+static const CmdEventName cmd_event_names[] = {
+    {"short", BTHomeShortPress},
+    {"double", BTHomeDoublePress},
+    {"triple", BTHomeTriplePress},
+    {"long", BTHomeLongPress},
+    {"long_double", BTHomeLongDoublePress},
+    {"long_triple", BTHomeLongTriplePress},
+};
+
+/**
+ * @brief      Add a received byte to the current line.
+ * @details    Both \r and \n end a line, empty lines such as the \n of a \r\n are skipped.
+ * @param      line  The line being received.
+ * @param      c     The received byte.
+ * @return     CmdLineReady when line->buf holds a complete line, valid until the next byte
+*/
+CmdLineStatus cmd_line_feed(CmdLine* line, char c) {
+    if(c == '\r' || c == '\n') {
+        CmdLineStatus status = CmdLineNone;
+        if(line->overflow) {
+            status = CmdLineTooLong;
+        } else if(line->len > 0) {
+            line->buf[line->len] = '\0';
+            status = CmdLineReady;
+        }
+        line->len = 0;
+        line->overflow = false;
+        return status;
+    }
+    if(line->len < CMD_LINE_SIZE - 1) {
+        line->buf[line->len++] = c;
+    } else {
+        line->overflow = true;
+    }
+    return CmdLineNone;
+}
+
+/**
+ * @brief      Look up a BTHome event by name, case insensitive.
+ * @param      name   The event name, e.g. "short" or "LONG_DOUBLE".
+ * @param      event  Filled with the BTHomeEventType on success.
+ * @return     true if the name is known
+*/
+bool cmd_event_from_name(const char* name, uint8_t* event) {
+    for(size_t i = 0; i < sizeof(cmd_event_names) / sizeof(cmd_event_names[0]); i++) {
+        if(strcasecmp(name, cmd_event_names[i].name) == 0) {
+            *event = cmd_event_names[i].event;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief      Split the next space separated token, in place.
+ * @param      cursor  The parse position, moved past the token.
+ * @return     the token, NULL at the end of the line
+*/
+static char* cmd_next_token(char** cursor) {
+    char* start = *cursor;
+    while(*start == ' ' || *start == '\t') {
+        start++;
+    }
+    if(*start == '\0') {
+        *cursor = start;
+        return NULL;
+    }
+    char* end = start;
+    while(*end && *end != ' ' && *end != '\t') {
+        end++;
+    }
+    if(*end) {
+        *end++ = '\0';
+    }
+    *cursor = end;
+    return start;
+}
+
+/**
+ * @brief      Parse an unsigned decimal token.
+ * @return     false if the token is not a number or is above max
+*/
+static bool cmd_parse_uint(const char* token, uint32_t max, uint32_t* value) {
+    char* end;
+    if(token == NULL || *token == '\0') {
+        return false;
+    }
+    *value = strtoul(token, &end, 10);
+    return *end == '\0' && *value <= max;
+}
+
+/**
+ * @brief      Parse a decimal number with up to two fractional digits, scaled by 100.
+ * @details    Done by hand so the RX path does not need float formatting support.
+ * @return     false if the token is not a number
+*/
+static bool cmd_parse_centi(const char* token, int32_t* value) {
+    bool negative = false;
+    int32_t whole = 0;
+    int32_t frac = 0;
+    uint8_t frac_digits = 0;
+    bool digits = false;
+
+    if(*token == '-' || *token == '+') {
+        negative = *token++ == '-';
+    }
+    for(; *token >= '0' && *token <= '9'; token++) {
+        whole = whole * 10 + (*token - '0');
+        digits = true;
+        if(whole > 1000000) {
+            return false;
+        }
+    }
+    if(*token == '.') {
+        for(token++; *token >= '0' && *token <= '9'; token++) {
+            if(frac_digits < 2) {
+                frac = frac * 10 + (*token - '0');
+                frac_digits++;
+            }
+            digits = true;
+        }
+    }
+    if(!digits || *token != '\0') {
+        return false;
+    }
+    for(; frac_digits < 2; frac_digits++) {
+        frac *= 10;
+    }
+    *value = (whole * 100 + frac) * (negative ? -1 : 1);
+    return true;
+}
+
+static bool cmd_parse_press(const CmdParser* parser, char* args, Cmd* cmd, const char** error) {
+    uint32_t button;
+    if(!cmd_parse_uint(cmd_next_token(&args), parser->button_count - 1, &button)) {
+        *error = "bad button";
+        return false;
+    }
+    const char* event = cmd_next_token(&args);
+    cmd->press.button = button;
+    cmd->press.event = BTHomeShortPress;
+    if(event && !cmd_event_from_name(event, &cmd->press.event)) {
+        *error = "bad event";
+        return false;
+    }
+    return true;
+}
+
+static bool cmd_parse_sensor(char* args, Cmd* cmd, const char** error) {
+    char* token;
+    cmd->sensor.mask = 0;
+    while((token = cmd_next_token(&args)) != NULL) {
+        char* value = strchr(token, '=');
+        int32_t centi;
+        if(value == NULL || !cmd_parse_centi(value + 1, &centi)) {
+            *error = "bad value";
+            return false;
+        }
+        *value = '\0';
+        if(strcasecmp(token, "temp") == 0 && centi >= INT16_MIN && centi <= INT16_MAX) {
+            cmd->sensor.temperature = centi;
+            cmd->sensor.mask |= CmdSensorTemperature;
+        } else if(strcasecmp(token, "batt") == 0 && centi >= 0 && centi <= 10000) {
+            cmd->sensor.battery = centi / 100;
+            cmd->sensor.mask |= CmdSensorBattery;
+        } else if(strcasecmp(token, "volt") == 0 && centi >= 0 && centi <= 6553) {
+            cmd->sensor.voltage = centi * 10;
+            cmd->sensor.mask |= CmdSensorVoltage;
+        } else {
+            *error = "bad field";
+            return false;
+        }
+    }
+    if(cmd->sensor.mask == 0) {
+        *error = "no field";
+        return false;
+    }
+    return true;
+}
+
+static bool cmd_parse_profile(const CmdParser* parser, char* args, Cmd* cmd, const char** error) {
+    const char* name = cmd_next_token(&args);
+    uint32_t index;
+    if(name == NULL) {
+        *error = "no profile";
+        return false;
+    }
+    if(cmd_parse_uint(name, parser->profile_count - 1, &index)) {
+        cmd->profile.index = index;
+        return true;
+    }
+    for(uint8_t i = 0; i < parser->profile_count; i++) {
+        if(strcasecmp(name, parser->profile_names[i]) == 0) {
+            cmd->profile.index = i;
+            return true;
+        }
+    }
+    *error = "unknown profile";
+    return false;
+}
+
+static bool cmd_parse_name(char* args, Cmd* cmd, const char** error) {
+    while(*args == ' ' || *args == '\t') {
+        args++;
+    }
+    // The name is the rest of the line, spaces included
+    size_t len = strlen(args);
+    if(len == 0 || len >= CMD_NAME_SIZE) {
+        *error = "bad name length";
+        return false;
+    }
+    memcpy(cmd->name, args, len + 1);
+    return true;
+}
+
+static bool cmd_parse_ms(char* args, uint32_t min, uint32_t max, Cmd* cmd, const char** error) {
+    uint32_t ms;
+    if(!cmd_parse_uint(cmd_next_token(&args), max, &ms) || ms < min) {
+        *error = "out of range";
+        return false;
+    }
+    cmd->ms = ms;
+    return true;
+}
+
+/**
+ * @brief      Parse a command line, no allocation is done.
+ * @param      parser  The names and limits of the running app.
+ * @param      line    The null terminated line, without the line ending, modified in place.
+ * @param      cmd     Filled on success.
+ * @param      error   Set to a short message on failure.
+ * @return     true if the line is a valid command
+*/
+bool cmd_parse(const CmdParser* parser, char* line, Cmd* cmd, const char** error) {
+    char* cursor = line;
+    const char* verb = cmd_next_token(&cursor);
+    if(verb == NULL) {
+        *error = "empty line";
+        return false;
+    }
+    if(strcasecmp(verb, "PRESS") == 0 || strcasecmp(verb, "SEND") == 0) {
+        cmd->type = CmdPress;
+        return cmd_parse_press(parser, cursor, cmd, error);
+    }
+    if(strcasecmp(verb, "SENSOR") == 0) {
+        cmd->type = CmdSensor;
+        return cmd_parse_sensor(cursor, cmd, error);
+    }
+    if(strcasecmp(verb, "PROFILE") == 0) {
+        cmd->type = CmdProfile;
+        return cmd_parse_profile(parser, cursor, cmd, error);
+    }
+    if(strcasecmp(verb, "NAME") == 0) {
+        cmd->type = CmdName;
+        return cmd_parse_name(cursor, cmd, error);
+    }
+    if(strcasecmp(verb, "INTERVAL") == 0) {
+        cmd->type = CmdInterval;
+        return cmd_parse_ms(cursor, CMD_INTERVAL_MIN, CMD_INTERVAL_MAX, cmd, error);
+    }
+    if(strcasecmp(verb, "DURATION") == 0) {
+        cmd->type = CmdDuration;
+        return cmd_parse_ms(cursor, CMD_DURATION_MIN, CMD_DURATION_MAX, cmd, error);
+    }
+    *error = "unknown command";
+    return false;
+}
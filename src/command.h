@@ -0,0 +1,72 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+// Line protocol to drive the beacon from outside the GUI, e.g. "PRESS 1 SHORT".
+// It has no furi dependency so it can be driven from a host build.
+
+#define CMD_LINE_SIZE    64
+#define CMD_NAME_SIZE    16 // Device name, null terminated
+#define CMD_INTERVAL_MIN 20 // ms, BLE minimum advertising interval
+#define CMD_INTERVAL_MAX 4551 // ms, 1.5x plus 50 % jitter stays within the HAL 10240 ms
+#define CMD_DURATION_MIN 100 // ms
+#define CMD_DURATION_MAX 60000
+
+typedef enum {
+    CmdPress, // PRESS|SEND <button> [event]
+    CmdSensor, // SENSOR [temp=<C>] [batt=<%>] [volt=<V>]
+    CmdProfile, // PROFILE <name or index>
+    CmdName, // NAME <device name>
+    CmdInterval, // INTERVAL <ms>
+    CmdDuration, // DURATION <ms>
+} CmdType;
+
+typedef enum {
+    CmdSensorBattery = 1 << 0,
+    CmdSensorTemperature = 1 << 1,
+    CmdSensorVoltage = 1 << 2,
+} CmdSensorMask;
+
+typedef struct {
+    uint8_t type;
+    union {
+        struct {
+            uint8_t button;
+            uint8_t event;
+        } press;
+        struct {
+            uint8_t mask; // CmdSensorMask of the fields set
+            uint8_t battery; // %
+            int16_t temperature; // 0.01 C
+            uint16_t voltage; // mV
+        } sensor;
+        struct {
+            uint8_t index;
+        } profile;
+        char name[CMD_NAME_SIZE];
+        uint16_t ms; // Interval or duration
+    };
+    uint32_t tick; // When it was queued, for the latency stats
+} Cmd;
+
+typedef enum {
+    CmdLineNone, // The line is not complete yet
+    CmdLineReady, // A line is in buf, null terminated
+    CmdLineTooLong, // The line was longer than the buffer and was dropped
+} CmdLineStatus;
+
+typedef struct {
+    char buf[CMD_LINE_SIZE];
+    uint8_t len;
+    bool overflow; // The current line is too long, drop it
+} CmdLine;
+
+typedef struct {
+    const char* const* profile_names;
+    uint8_t profile_count;
+    uint8_t button_count;
+} CmdParser;
+
+CmdLineStatus cmd_line_feed(CmdLine* line, char c);
+bool cmd_event_from_name(const char* name, uint8_t* event);
+bool cmd_parse(const CmdParser* parser, char* line, Cmd* cmd, const char** error);
@@ -0,0 +1,183 @@
+#include "counter_store.h"
+#include "libs/alloc_tracker.h"
+#include <storage/storage.h>
+
+#define COUNTER_TAG   "COUNTER"
+#define COUNTER_MAGIC 0xB7C0FFEEUL
+
+typedef enum {
+    CounterEventStop = 1 << 0,
+    CounterEventWrite = 1 << 1,
+} CounterEvent;
+
+typedef struct {
+    uint32_t seq; // Write sequence, the highest valid one is the current record
+    uint32_t value; // Next counter value free to use
+    uint32_t check;
+} CounterRecord;
+
+struct CounterStore {
+    FuriThread* thread;
+    FuriThreadId thread_id;
+    const char* path;
+    uint32_t seq; // Of the last record written
+    uint32_t value; // Last value handed out, owned by the caller thread
+    volatile uint32_t reserved; // Values below this are on the card
+    volatile uint32_t requested; // Reservation asked to the thread
+    uint32_t writes;
+};
+
+static uint32_t counter_record_check(const CounterRecord* record) {
+    return record->seq ^ record->value ^ COUNTER_MAGIC;
+}
+
+/**
+ * @brief      Write a record in the next slot of the ring.
+ * @details    Only the slot is rewritten, the other records stay valid if this write is cut.
+ * @param      store  the CounterStore object
+ * @param      value  the value to save
+ * @return     true if the record was written
+*/
+static bool counter_store_write(CounterStore* store, uint32_t value) {
+    CounterRecord record = {.seq = store->seq + 1, .value = value};
+    record.check = counter_record_check(&record);
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool written = false;
+    if(storage_file_open(file, store->path, FSAM_WRITE, FSOM_OPEN_ALWAYS)) {
+        const uint32_t offset = (record.seq % COUNTER_SLOTS) * sizeof(CounterRecord);
+        written = storage_file_seek(file, offset, true) &&
+                  storage_file_write(file, &record, sizeof(record)) == sizeof(record);
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+
+    if(written) {
+        store->seq = record.seq;
+        store->writes++;
+    } else {
+        FURI_LOG_E(COUNTER_TAG, "Error writing %s", store->path);
+    }
+    return written;
+}
+
+/**
+ * @brief      Find the newest valid record, a missing or damaged file starts from 0.
+ * @details    The file is created with all the slots, so later writes never grow it.
+*/
+static void counter_store_load(CounterStore* store) {
+    CounterRecord records[COUNTER_SLOTS] = {0};
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool complete = false;
+    if(storage_file_open(file, store->path, FSAM_READ_WRITE, FSOM_OPEN_ALWAYS)) {
+        complete = storage_file_read(file, records, sizeof(records)) == sizeof(records);
+        if(!complete) {
+            memset(records, 0, sizeof(records));
+            storage_file_seek(file, 0, true);
+            storage_file_write(file, records, sizeof(records));
+        }
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+
+    bool found = false;
+    for(uint8_t i = 0; i < COUNTER_SLOTS && complete; i++) {
+        const CounterRecord* record = &records[i];
+        if(record->check == counter_record_check(record) && (!found || record->seq > store->seq)) {
+            store->seq = record->seq;
+            store->reserved = record->value;
+            found = true;
+        }
+    }
+    FURI_LOG_I(COUNTER_TAG, "Resuming from %lu, record %lu", store->reserved, store->seq);
+}
+
+static int32_t counter_store_worker(void* context) {
+    CounterStore* store = (CounterStore*)context;
+
+    while(true) {
+        uint32_t events = furi_thread_flags_wait(
+            CounterEventStop | CounterEventWrite, FuriFlagWaitAny, FuriWaitForever);
+        if(events & FuriFlagError) {
+            continue;
+        }
+        if(events & CounterEventStop) {
+            break;
+        }
+        const uint32_t requested = store->requested;
+        if(requested != store->reserved && counter_store_write(store, requested)) {
+            store->reserved = requested;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief      Load the counter and reserve the first block.
+ * @param      path  the counter file path
+ * @return     the CounterStore object
+*/
+CounterStore* counter_store_alloc(const char* path) {
+    CounterStore* store = ATRACK_MALLOC(sizeof(CounterStore));
+    memset(store, 0, sizeof(CounterStore));
+    store->path = path;
+    counter_store_load(store);
+    // Values up to the reservation may have been used before a crash, skip them all
+    store->value = store->reserved;
+    store->requested = store->reserved + COUNTER_BLOCK;
+
+    store->thread = furi_thread_alloc_ex("CounterStore", 1024, counter_store_worker, store);
+    furi_thread_set_priority(store->thread, FuriThreadPriorityLow);
+    furi_thread_start(store->thread);
+    store->thread_id = furi_thread_get_id(store->thread);
+    furi_thread_flags_set(store->thread_id, CounterEventWrite);
+    return store;
+}
+
+/**
+ * @brief      Stop the thread and save the exact next value, nothing is skipped on the next start.
+ * @param      store  the CounterStore object
+*/
+void counter_store_free(CounterStore* store) {
+    furi_thread_flags_set(store->thread_id, CounterEventStop);
+    furi_thread_join(store->thread);
+    furi_thread_free(store->thread);
+    counter_store_write(store, store->value);
+    FURI_LOG_I(COUNTER_TAG, "Saved %lu after %lu writes", store->value, store->writes);
+    ATRACK_FREE(store);
+}
+
+/**
+ * @brief      Take the next counter value, never touches the storage.
+ * @details    Called from a single thread. The next block is asked when half of the current one
+ *             is used, so the write is done long before the values run out.
+ * @param      store  the CounterStore object
+ * @return     the counter value
+*/
+uint32_t counter_store_next(CounterStore* store) {
+    const uint32_t value = store->value++;
+    if(store->requested == store->reserved &&
+       store->value + COUNTER_BLOCK / 2 >= store->reserved) {
+        store->requested = store->reserved + COUNTER_BLOCK;
+        furi_thread_flags_set(store->thread_id, CounterEventWrite);
+    }
+    if(store->value > store->reserved) {
+        FURI_LOG_W(COUNTER_TAG, "Reservation late, %lu over %lu", store->value, store->reserved);
+    }
+    return value;
+}
+
+/**
+ * @brief      The next value to hand out, the packets counted since the first run.
+*/
+uint32_t counter_store_get(const CounterStore* store) {
+    return store->value;
+}
+
+uint32_t counter_store_writes(const CounterStore* store) {
+    return store->writes;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <furi.h>
+
+// Packet counter that survives restarts, so receivers don't drop the first presses as duplicates.
+// It is saved in a ring of records, IDs are reserved by blocks and written by a worker thread.
+
+#define COUNTER_FILE_NAME "counter.bin"
+#define COUNTER_SLOTS     16 // Records in the ring, every write goes to the next one
+#define COUNTER_BLOCK     64 // IDs reserved by one write
+
+typedef struct CounterStore CounterStore;
+
+CounterStore* counter_store_alloc(const char* path);
+void counter_store_free(CounterStore* store);
+uint32_t counter_store_next(CounterStore* store);
+uint32_t counter_store_get(const CounterStore* store);
+uint32_t counter_store_writes(const CounterStore* store);
@@ -0,0 +1,268 @@
+#include "file_viewer.h"
+#include "libs/furi_utils.h"
+#include <gui/elements.h>
+#include <storage/storage.h>
+
+#define FILE_VIEWER_TAG "FILE_VIEWER"
+
+struct FileViewer {
+    View* view;
+};
+
+typedef struct {
+    char path[FILE_VIEWER_PATH_SIZE];
+    const char* title;
+    // Sparse index, offsets[i] is where row i * stride starts
+    uint32_t offsets[FILE_VIEWER_INDEX_SIZE];
+    uint8_t index_count;
+    uint16_t stride;
+    uint32_t scanned_rows; // Rows seen so far, the index covers them
+    uint32_t scanned_offset; // Where the first row not seen yet starts
+    bool eof; // scanned_rows is the row count of the file
+    // Window on screen
+    uint32_t top;
+    char rows[FILE_VIEWER_ROWS][FILE_VIEWER_COLS + 1];
+    uint8_t row_count;
+    bool error;
+} FileViewerModel;
+
+typedef struct {
+    File* file;
+    uint8_t buffer[64];
+    size_t len;
+    size_t pos;
+    uint32_t offset; // Of the next byte to read
+} FileViewerReader;
+
+static bool file_viewer_getc(FileViewerReader* reader, char* c) {
+    if(reader->pos == reader->len) {
+        reader->len = storage_file_read(reader->file, reader->buffer, sizeof(reader->buffer));
+        reader->pos = 0;
+        if(reader->len == 0) {
+            return false;
+        }
+    }
+    *c = reader->buffer[reader->pos++];
+    reader->offset++;
+    return true;
+}
+
+static void file_viewer_ungetc(FileViewerReader* reader) {
+    reader->pos--;
+    reader->offset--;
+}
+
+/**
+ * @brief      Read one row, up to a line ending or FILE_VIEWER_COLS characters.
+ * @param      reader  the reader
+ * @param      row     filled with the row, NULL to skip it
+ * @return     false at the end of the file
+*/
+static bool file_viewer_read_row(FileViewerReader* reader, char* row) {
+    uint8_t len = 0;
+    bool any = false;
+    char c;
+    while(file_viewer_getc(reader, &c)) {
+        any = true;
+        if(c == '\n') {
+            break;
+        }
+        if(c == '\r') {
+            continue;
+        }
+        if(len == FILE_VIEWER_COLS) {
+            // Wrap, the character starts the next row
+            file_viewer_ungetc(reader);
+            break;
+        }
+        if(row) {
+            row[len] = c == '\t' ? ' ' : c;
+        }
+        len++;
+    }
+    if(row) {
+        row[len] = '\0';
+    }
+    return any;
+}
+
+/**
+ * @brief      Account a row seen for the first time in the sparse index.
+ * @details    When the index is full every other entry is dropped and the stride doubles.
+*/
+static void file_viewer_index_add(FileViewerModel* model, uint32_t row, uint32_t offset) {
+    if(row != model->index_count * model->stride) {
+        return;
+    }
+    if(model->index_count == FILE_VIEWER_INDEX_SIZE) {
+        for(uint8_t i = 0; i < FILE_VIEWER_INDEX_SIZE / 2; i++) {
+            model->offsets[i] = model->offsets[i * 2];
+        }
+        model->index_count = FILE_VIEWER_INDEX_SIZE / 2;
+        model->stride *= 2;
+        if(row != model->index_count * model->stride) {
+            return;
+        }
+    }
+    model->offsets[model->index_count++] = offset;
+}
+
+/**
+ * @brief      Read the rows of the window from the file.
+ * @details    The read starts from the closest indexed row before the window, rows past the
+ *             scanned part are added to the index on the way.
+*/
+static void file_viewer_load(FileViewerModel* model) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    FileViewerReader reader = {.file = storage_file_alloc(storage)};
+    model->row_count = 0;
+    model->error = !storage_file_open(reader.file, model->path, FSAM_READ, FSOM_OPEN_EXISTING);
+
+    if(!model->error) {
+        uint32_t row;
+        if(model->top >= model->scanned_rows) {
+            row = model->scanned_rows;
+            reader.offset = model->scanned_offset;
+        } else {
+            const uint8_t entry = MIN(model->top / model->stride, model->index_count - 1U);
+            row = entry * model->stride;
+            reader.offset = model->offsets[entry];
+        }
+        storage_file_seek(reader.file, reader.offset, true);
+
+        while(model->row_count < FILE_VIEWER_ROWS) {
+            const uint32_t start = reader.offset;
+            char* out = row >= model->top ? model->rows[model->row_count] : NULL;
+            if(!file_viewer_read_row(&reader, out)) {
+                if(row >= model->scanned_rows) {
+                    model->eof = true;
+                }
+                break;
+            }
+            if(row == model->scanned_rows) {
+                file_viewer_index_add(model, row, start);
+                model->scanned_rows = row + 1;
+                model->scanned_offset = reader.offset;
+            }
+            if(out) {
+                model->row_count++;
+            }
+            row++;
+        }
+    } else {
+        FURI_LOG_E(FILE_VIEWER_TAG, "Error opening %s", model->path);
+    }
+    storage_file_close(reader.file);
+    storage_file_free(reader.file);
+    furi_record_close(RECORD_STORAGE);
+}
+
+static void file_viewer_draw_callback(Canvas* canvas, void* model) {
+    FileViewerModel* fv_model = (FileViewerModel*)model;
+
+    canvas_clear(canvas);
+    futils_draw_header(canvas, fv_model->title, fv_model->top / FILE_VIEWER_ROWS, 8);
+    if(fv_model->error) {
+        canvas_draw_str(canvas, 0, 18, "File not found");
+        return;
+    }
+    canvas_set_font(canvas, FontKeyboard);
+    for(uint8_t i = 0; i < fv_model->row_count; i++) {
+        canvas_draw_str(canvas, 0, 18 + i * 10, fv_model->rows[i]);
+    }
+    canvas_set_font(canvas, FontSecondary);
+    // The total is only known once the end was seen, until then the bar tracks the scanned part
+    elements_scrollbar(canvas, fv_model->top, MAX(fv_model->scanned_rows, 1U));
+}
+
+/**
+ * @brief      Scroll by a row with Up/Down and by a page with Left/Right.
+*/
+static bool file_viewer_input_callback(InputEvent* event, void* context) {
+    FileViewer* viewer = (FileViewer*)context;
+    if(event->type != InputTypeShort && event->type != InputTypeRepeat) {
+        return false;
+    }
+
+    bool consumed = true;
+    with_view_model(
+        viewer->view,
+        FileViewerModel * model,
+        {
+            uint32_t top = model->top;
+            switch(event->key) {
+            case InputKeyUp:
+                top = top > 0 ? top - 1 : 0;
+                break;
+            case InputKeyLeft:
+                top = top > FILE_VIEWER_ROWS ? top - FILE_VIEWER_ROWS : 0;
+                break;
+            case InputKeyDown:
+                top++;
+                break;
+            case InputKeyRight:
+                top += FILE_VIEWER_ROWS;
+                break;
+            default:
+                consumed = false;
+                break;
+            }
+            if(model->eof && top + FILE_VIEWER_ROWS > model->scanned_rows) {
+                top = model->scanned_rows > FILE_VIEWER_ROWS ?
+                          model->scanned_rows - FILE_VIEWER_ROWS :
+                          0;
+            }
+            if(consumed && top != model->top && !model->error) {
+                const uint32_t prev = model->top;
+                model->top = top;
+                file_viewer_load(model);
+                if(model->row_count == 0 && top > 0) {
+                    // Past the end, the end is known now
+                    model->top = prev;
+                    file_viewer_load(model);
+                }
+            }
+        },
+        consumed);
+    return consumed;
+}
+
+FileViewer* file_viewer_alloc(void) {
+    FileViewer* viewer = ATRACK_MALLOC(sizeof(FileViewer));
+    viewer->view = view_alloc();
+    view_set_context(viewer->view, viewer);
+    view_set_draw_callback(viewer->view, file_viewer_draw_callback);
+    view_set_input_callback(viewer->view, file_viewer_input_callback);
+    view_allocate_model(viewer->view, ViewModelTypeLocking, sizeof(FileViewerModel));
+    return viewer;
+}
+
+void file_viewer_free(FileViewer* viewer) {
+    view_free(viewer->view);
+    ATRACK_FREE(viewer);
+}
+
+View* file_viewer_get_view(FileViewer* viewer) {
+    return viewer->view;
+}
+
+/**
+ * @brief      Show a file from its first row, only the first screen is read.
+ * @param      viewer  the FileViewer object
+ * @param      path    the file path
+ * @param      title   the header, must outlive the view
+*/
+void file_viewer_set_file(FileViewer* viewer, const char* path, const char* title) {
+    with_view_model(
+        viewer->view,
+        FileViewerModel * model,
+        {
+            memset(model, 0, sizeof(FileViewerModel));
+            futils_copy_str(
+                model->path, path, sizeof(model->path), "file_viewer_set_file", "model->path");
+            model->title = title;
+            model->stride = 1;
+            file_viewer_load(model);
+        },
+        true);
+}
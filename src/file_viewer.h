@@ -0,0 +1,18 @@
+#pragma once
+#include <furi.h>
+#include <gui/view.h>
+
+// Read-only text file view that only reads the rows on screen.
+// Row offsets are kept in a sparse index of fixed size, so the memory doesn't depend on the file.
+
+#define FILE_VIEWER_COLS       20 // Longer lines are wrapped
+#define FILE_VIEWER_ROWS       5
+#define FILE_VIEWER_INDEX_SIZE 32 // Indexed rows, the stride doubles when it's full
+#define FILE_VIEWER_PATH_SIZE  96
+
+typedef struct FileViewer FileViewer;
+
+FileViewer* file_viewer_alloc(void);
+void file_viewer_free(FileViewer* viewer);
+View* file_viewer_get_view(FileViewer* viewer);
+void file_viewer_set_file(FileViewer* viewer, const char* path, const char* title);
@@ -0,0 +1,236 @@
+#include "fleet_sim.h"
+#include "libs/random_below.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FLEET_SIM_CHANNELS 3
+
+typedef struct {
+    uint32_t rng;
+    uint32_t now_us; // Virtual clock of the device
+    uint32_t press_us;
+    bool on; // The beacon was started
+    uint32_t next_us; // Start of the next advertising event
+    uint32_t timer_us; // Next call to adv_sched_next()
+    uint32_t interval_us; // Picked by the controller in the range of the config
+    AdvSched sched;
+} FleetSimDevice;
+
+static uint32_t fleet_sim_word(void* context) {
+    // xorshift32, every device has its own so both passes see the same events
+    uint32_t* state = context;
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static uint32_t fleet_sim_below(FleetSimDevice* device, uint32_t bound) {
+    return random_below(bound, fleet_sim_word, &device->rng);
+}
+
+static uint32_t fleet_sim_random_below(uint32_t bound, void* context) {
+    return fleet_sim_below(context, bound);
+}
+
+/**
+ * @brief      The controller picks the interval once per config, a beacon on air is restarted
+ *             and sends its next event right away.
+*/
+static void fleet_sim_set_interval(uint32_t min_ms, uint32_t max_ms, void* context) {
+    FleetSimDevice* device = context;
+    device->interval_us = (min_ms + fleet_sim_below(device, max_ms - min_ms + 1)) * 1000;
+    if(device->on) {
+        device->next_us = device->now_us;
+    }
+}
+
+static void fleet_sim_start(uint32_t delay_ms, void* context) {
+    FleetSimDevice* device = context;
+    device->on = true;
+    device->next_us = device->now_us + delay_ms * 1000;
+}
+
+static void fleet_sim_timer(uint32_t ms, void* context) {
+    FleetSimDevice* device = context;
+    device->timer_us = device->now_us + ms * 1000;
+}
+
+/**
+ * @brief      Press a device: draw the press time and begin its schedule, like the comm worker.
+ * @param      config  The FleetSimConfig.
+ * @param      index   The device index, seeds its random numbers.
+ * @param      device  The FleetSimDevice.
+ * @param      hal     Set to the modeled radio of the device.
+*/
+static void fleet_sim_device_init(
+    const FleetSimConfig* config,
+    uint32_t index,
+    FleetSimDevice* device,
+    AdvSchedHal* hal) {
+    memset(device, 0, sizeof(FleetSimDevice));
+    device->rng = config->seed ^ ((index + 1) * 0x9E3779B9UL);
+    if(device->rng == 0) {
+        device->rng = 1;
+    }
+    *hal = (AdvSchedHal){
+        .random_below = fleet_sim_random_below,
+        .set_interval = fleet_sim_set_interval,
+        .start = fleet_sim_start,
+        .timer = fleet_sim_timer,
+        .context = device,
+    };
+    device->press_us = fleet_sim_below(device, config->spread_ms * 1000 + 1);
+    device->now_us = device->press_us;
+    adv_sched_begin(&device->sched, &config->sched, hal, true);
+    adv_sched_start(&device->sched, &config->sched, hal, true);
+}
+
+/**
+ * @brief      Run the device up to its next advertising event.
+ * @details    The schedule steps that are due first are taken, the last one stops the beacon.
+ * @return     false once the beacon is stopped
+*/
+static bool fleet_sim_device_next(
+    const FleetSimConfig* config,
+    FleetSimDevice* device,
+    const AdvSchedHal* hal,
+    uint32_t* event_us) {
+    while(device->next_us >= device->timer_us) {
+        device->now_us = device->timer_us;
+        if(!adv_sched_next(&device->sched, &config->sched, hal)) {
+            return false;
+        }
+    }
+    *event_us = device->now_us = device->next_us;
+    device->next_us += device->interval_us + fleet_sim_below(device, ADV_DELAY_MAX * 1000 + 1);
+    return true;
+}
+
+/**
+ * @brief      Time of the first PDU of the event the scanner receives.
+ * @return     the PDU time, or UINT32_MAX if the scanner hears none
+*/
+static uint32_t fleet_sim_scan(const FleetSimConfig* config, uint32_t event_us) {
+    uint32_t pdu_us = event_us;
+    for(uint8_t channel = 0; channel < FLEET_SIM_CHANNELS; channel++) {
+        if(!(config->channel_map & (1U << channel))) {
+            continue;
+        }
+        if(pdu_us / 1000 / FLEET_SIM_SCAN_WINDOW_MS % FLEET_SIM_CHANNELS == channel) {
+            return pdu_us;
+        }
+        pdu_us += config->pdu_us + FLEET_SIM_CHANNEL_GAP_US;
+    }
+    return UINT32_MAX;
+}
+
+/**
+ * @brief      Simulated time the timeline must cover, from the settings.
+*/
+static uint32_t fleet_sim_horizon_us(const FleetSimConfig* config) {
+    const uint32_t ms =
+        config->spread_ms + config->sched.offset_ms + adv_sched_max_window_ms(&config->sched);
+    return ms * 1000 + config->pdu_us;
+}
+
+static uint16_t fleet_sim_percentile(
+    const uint32_t* histogram,
+    uint32_t step,
+    uint32_t count,
+    uint8_t pct) {
+    const uint32_t target = (count * pct + 99) / 100;
+    uint32_t seen = 0;
+    for(uint16_t b = 0; b < FLEET_SIM_LATENCY_COUNT; b++) {
+        seen += histogram[b];
+        if(seen >= target) {
+            return b * step;
+        }
+    }
+    return FLEET_SIM_LATENCY_COUNT * step;
+}
+
+/**
+ * @brief      Run the fleet on the virtual clock.
+ * @details    The first pass marks the air time of every event, the second one replays the same
+ *             events and finds the ones that had the air to themselves.
+ * @param      config  The fleet and its advertising settings.
+ * @param      result  Filled with the delivery, collisions and latency.
+ * @return     false if the memory is missing
+*/
+bool fleet_sim_run(const FleetSimConfig* config, FleetSimResult* result) {
+    memset(result, 0, sizeof(FleetSimResult));
+    if(config->sched.period_ms == 0) {
+        return false;
+    }
+    const uint32_t horizon_us = fleet_sim_horizon_us(config);
+    const uint32_t slots = horizon_us / FLEET_SIM_SLOT_US + 1;
+    // Every latency fits the histogram, it can't be longer than the simulated time
+    uint32_t latency_step = horizon_us / 1000 / FLEET_SIM_LATENCY_COUNT + 1;
+    if(latency_step < FLEET_SIM_LATENCY_STEP) {
+        latency_step = FLEET_SIM_LATENCY_STEP;
+    }
+    const uint32_t words = (slots + 31) / 32;
+    uint32_t* once = calloc(words * 2, sizeof(uint32_t));
+    uint32_t* histogram = calloc(FLEET_SIM_LATENCY_COUNT, sizeof(uint32_t));
+    if(once == NULL || histogram == NULL) {
+        free(once);
+        free(histogram);
+        return false;
+    }
+    uint32_t* twice = &once[words];
+    FleetSimDevice device;
+    AdvSchedHal hal;
+    uint32_t event_us;
+
+    for(uint32_t d = 0; d < config->devices; d++) {
+        fleet_sim_device_init(config, d, &device, &hal);
+        while(fleet_sim_device_next(config, &device, &hal, &event_us)) {
+            const uint32_t last = (event_us + config->pdu_us - 1) / FLEET_SIM_SLOT_US;
+            for(uint32_t s = event_us / FLEET_SIM_SLOT_US; s <= last; s++) {
+                const uint32_t bit = 1UL << (s % 32);
+                if(once[s / 32] & bit) {
+                    twice[s / 32] |= bit;
+                } else {
+                    once[s / 32] |= bit;
+                }
+            }
+        }
+    }
+
+    for(uint32_t d = 0; d < config->devices; d++) {
+        fleet_sim_device_init(config, d, &device, &hal);
+        bool delivered = false;
+        while(fleet_sim_device_next(config, &device, &hal, &event_us)) {
+            const uint32_t last = (event_us + config->pdu_us - 1) / FLEET_SIM_SLOT_US;
+            bool clean = true;
+            for(uint32_t s = event_us / FLEET_SIM_SLOT_US; s <= last && clean; s++) {
+                clean = !(twice[s / 32] & (1UL << (s % 32)));
+            }
+            result->events++;
+            if(!clean) {
+                result->collided++;
+                continue;
+            }
+            const uint32_t heard_us = fleet_sim_scan(config, event_us);
+            if(!delivered && heard_us != UINT32_MAX) {
+                delivered = true;
+                histogram[(heard_us - device.press_us) / 1000 / latency_step]++;
+            }
+        }
+        result->presses++;
+        result->delivered += delivered;
+    }
+
+    if(result->delivered) {
+        result->latency_p50 = fleet_sim_percentile(histogram, latency_step, result->delivered, 50);
+        result->latency_p90 = fleet_sim_percentile(histogram, latency_step, result->delivered, 90);
+        result->latency_p99 = fleet_sim_percentile(histogram, latency_step, result->delivered, 99);
+    }
+    result->sim_ms = slots * FLEET_SIM_SLOT_US / 1000;
+    free(once);
+    free(histogram);
+    return true;
+}
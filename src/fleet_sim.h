@@ -0,0 +1,42 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "adv_sched.h"
+
+// Many remotes pressed around the same time against one modeled scanner, on a virtual clock.
+// It has no furi dependency so it can be driven from a host build.
+// Every remote runs the advertising schedule of the comm worker (adv_sched) with a modeled radio:
+// the controller picks an interval in the range it's given and adds its random delay to every
+// event, which sends a PDU on each channel of the map. A PDU is lost when it overlaps another
+// one on its channel, or when the scanner listens on another channel. All the remotes share the
+// channel map and the PDU size, so two events collide on every channel or on none: the timeline
+// only keeps the first PDUs, as two bitmaps (seen once, seen more than once), so the memory only
+// depends on the simulated time, not on the fleet.
+
+#define FLEET_SIM_SLOT_US        100 // Timeline resolution
+#define FLEET_SIM_CHANNEL_GAP_US 200 // Between the PDUs of an event
+#define FLEET_SIM_SCAN_WINDOW_MS 30 // The scanner hops 37, 38, 39 at this period
+#define FLEET_SIM_LATENCY_STEP   2 // Min ms per latency histogram bucket
+#define FLEET_SIM_LATENCY_COUNT  512 // Buckets, the step grows with the simulated time
+
+typedef struct {
+    uint32_t devices;
+    uint32_t spread_ms; // The presses are spread evenly at random over this time
+    AdvSchedConfig sched; // Advertising settings, as the comm worker takes them
+    uint8_t channel_map; // Bit 0 is channel 37, as GapAdvChannelMap
+    uint16_t pdu_us; // Air time of one PDU
+    uint32_t seed;
+} FleetSimConfig;
+
+typedef struct {
+    uint32_t presses;
+    uint32_t delivered; // Presses with at least one PDU received
+    uint32_t events;
+    uint32_t collided;
+    uint16_t latency_p50; // ms from the press to the first PDU received
+    uint16_t latency_p90;
+    uint16_t latency_p99;
+    uint32_t sim_ms; // Simulated time
+} FleetSimResult;
+
+bool fleet_sim_run(const FleetSimConfig* config, FleetSimResult* result);
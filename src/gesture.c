@@ -0,0 +1,155 @@
+#include "gesture.h"
+#include "bthome.h"
+#include <string.h>
+
+static const uint8_t short_events[GESTURE_MAX_PRESSES] = {
+    BTHomeShortPress,
+    BTHomeDoublePress,
+    BTHomeTriplePress,
+};
+static const uint8_t long_events[GESTURE_MAX_PRESSES] = {
+    BTHomeLongPress,
+    BTHomeLongDoublePress,
+    BTHomeLongTriplePress,
+};
+
+/**
+ * @brief      Report an event and bring the key back to idle
+*/
+static void gesture_emit(Gesture* gesture, uint8_t key, const uint8_t* events) {
+    GestureKey* k = &gesture->keys[key];
+    gesture->callback(key, events[k->count - 1], gesture->context);
+    k->state = GestureStateIdle;
+    k->count = 0;
+}
+
+/**
+ * @brief      Initialize the recognizer
+ * @param      gesture   the recognizer
+ * @param      config    timing windows, max_presses is clamped to GESTURE_MAX_PRESSES
+ * @param      callback  called for every recognized event
+ * @param      context   context for the callback
+*/
+void gesture_init(
+    Gesture* gesture,
+    const GestureConfig* config,
+    GestureCallback callback,
+    void* context) {
+    gesture->config = *config;
+    if(gesture->config.max_presses == 0 || gesture->config.max_presses > GESTURE_MAX_PRESSES) {
+        gesture->config.max_presses = GESTURE_MAX_PRESSES;
+    }
+    gesture->callback = callback;
+    gesture->context = context;
+    gesture_reset(gesture);
+}
+
+/**
+ * @brief      Drop any gesture in progress without reporting it
+*/
+void gesture_reset(Gesture* gesture) {
+    memset(gesture->keys, 0, sizeof(gesture->keys));
+}
+
+/**
+ * @brief      Feed a key press
+ * @param      now  timestamp in ms
+*/
+void gesture_press(Gesture* gesture, uint8_t key, uint32_t now) {
+    if(key >= GESTURE_KEY_COUNT) return;
+    GestureKey* k = &gesture->keys[key];
+
+    switch(k->state) {
+    case GestureStateIdle:
+        k->count = 1;
+        break;
+    case GestureStateReleased:
+        if(now - k->ts >= gesture->config.multi_window_ms) {
+            // The window expired before the tick reported it, this press starts a new gesture
+            gesture_emit(gesture, key, short_events);
+            k->count = 1;
+        } else {
+            k->count++;
+        }
+        break;
+    default:
+        // Press without release, keep the current gesture
+        return;
+    }
+    k->state = GestureStatePressed;
+    k->ts = now;
+}
+
+/**
+ * @brief      Feed a key release
+ * @details    The event is reported right away when no further press can change it, that is
+ *             after a long hold or when the max press count is reached.
+ * @param      now  timestamp in ms
+*/
+void gesture_release(Gesture* gesture, uint8_t key, uint32_t now) {
+    if(key >= GESTURE_KEY_COUNT) return;
+    GestureKey* k = &gesture->keys[key];
+
+    switch(k->state) {
+    case GestureStatePressed:
+        if(now - k->ts >= gesture->config.long_ms) {
+            gesture_emit(gesture, key, long_events);
+        } else if(k->count >= gesture->config.max_presses) {
+            gesture_emit(gesture, key, short_events);
+        } else {
+            k->state = GestureStateReleased;
+            k->ts = now;
+        }
+        break;
+    case GestureStateLatched:
+        k->state = GestureStateIdle;
+        k->count = 0;
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief      Report every gesture whose window expired
+ * @param      now  timestamp in ms
+*/
+void gesture_tick(Gesture* gesture, uint32_t now) {
+    for(uint8_t key = 0; key < GESTURE_KEY_COUNT; key++) {
+        GestureKey* k = &gesture->keys[key];
+        if(k->state == GestureStatePressed && now - k->ts >= gesture->config.long_ms) {
+            // Report the long press while the key is still held
+            gesture->callback(key, long_events[k->count - 1], gesture->context);
+            k->state = GestureStateLatched;
+        } else if(
+            k->state == GestureStateReleased &&
+            now - k->ts >= gesture->config.multi_window_ms) {
+            gesture_emit(gesture, key, short_events);
+        }
+    }
+}
+
+/**
+ * @brief      Earliest time gesture_tick() has something to report
+ * @param      deadline  filled with the timestamp in ms
+ * @return     false if no gesture is pending
+*/
+bool gesture_next_deadline(const Gesture* gesture, uint32_t* deadline) {
+    bool pending = false;
+    for(uint8_t key = 0; key < GESTURE_KEY_COUNT; key++) {
+        const GestureKey* k = &gesture->keys[key];
+        uint32_t due;
+        if(k->state == GestureStatePressed) {
+            due = k->ts + gesture->config.long_ms;
+        } else if(k->state == GestureStateReleased) {
+            due = k->ts + gesture->config.multi_window_ms;
+        } else {
+            continue;
+        }
+        if(!pending || (int32_t)(due - *deadline) < 0) {
+            *deadline = due;
+            pending = true;
+        }
+    }
+    return pending;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+// Multi-press gesture recognizer, fed with raw press/release timestamps.
+// It has no furi dependency so it can be driven by synthetic input traces.
+
+#define GESTURE_KEY_COUNT   5
+#define GESTURE_MAX_PRESSES 3
+
+typedef void (*GestureCallback)(uint8_t key, uint8_t event, void* context);
+
+typedef struct {
+    uint16_t multi_window_ms; // Max gap between a release and the next press
+    uint16_t long_ms; // Hold time to report a long press
+    uint8_t max_presses; // 1 disables multi press detection
+} GestureConfig;
+
+typedef enum {
+    GestureStateIdle,
+    GestureStatePressed,
+    GestureStateReleased,
+    GestureStateLatched, // Long press already reported, waiting for release
+} GestureState;
+
+typedef struct {
+    uint8_t state;
+    uint8_t count;
+    uint32_t ts;
+} GestureKey;
+
+typedef struct {
+    GestureConfig config;
+    GestureKey keys[GESTURE_KEY_COUNT];
+    GestureCallback callback;
+    void* context;
+} Gesture;
+
+void gesture_init(
+    Gesture* gesture,
+    const GestureConfig* config,
+    GestureCallback callback,
+    void* context);
+void gesture_reset(Gesture* gesture);
+void gesture_press(Gesture* gesture, uint8_t key, uint32_t now);
+void gesture_release(Gesture* gesture, uint8_t key, uint32_t now);
+void gesture_tick(Gesture* gesture, uint32_t now);
+bool gesture_next_deadline(const Gesture* gesture, uint32_t* deadline);
@@ -0,0 +1,133 @@
+#include "heap_stats.h"
+#include "libs/furi_utils.h"
+
+#if ALLOC_TRACKER
+/**
+ * @brief      Number of pages: totals, operations and then the call sites.
+ * @param      stats  The stats snapshot
+ * @return     the page count
+*/
+static uint8_t heap_stats_page_count(const AtrackStats* stats) {
+    return 2 + (stats->site_count + HEAP_STATS_LINES - 1) / HEAP_STATS_LINES;
+}
+
+/**
+ * @brief      Callback of the heap stats screen on enter.
+ * @details    Take a fresh snapshot of the tracker stats.
+ * @param      context  The context - App object.
+*/
+void heap_stats_enter_callback(void* context) {
+    App* app = (App*)context;
+    with_view_model(
+        app->view_heap_stats, HeapStatsModel * model, { atrack_get_stats(&model->stats); }, true);
+}
+
+/**
+ * @brief      Callback for drawing the heap stats view.
+ * @param      canvas  The canvas to draw on.
+ * @param      model   The model - HeapStatsModel object.
+*/
+void heap_stats_draw_callback(Canvas* canvas, void* model) {
+    HeapStatsModel* hs_model = (HeapStatsModel*)model;
+    const AtrackStats* stats = &hs_model->stats;
+    char line[32];
+    int32_t y = 18;
+
+    canvas_clear(canvas);
+    switch(hs_model->page) {
+    case 0:
+        futils_draw_header(canvas, "Heap Totals", hs_model->page, 8);
+        snprintf(line, sizeof(line), "Live: %lu B", stats->live_bytes);
+        canvas_draw_str(canvas, 0, y, line);
+        y += 10;
+        snprintf(line, sizeof(line), "Peak: %lu B", stats->peak_bytes);
+        canvas_draw_str(canvas, 0, y, line);
+        y += 10;
+        snprintf(line, sizeof(line), "Allocs: %lu", stats->count);
+        canvas_draw_str(canvas, 0, y, line);
+        y += 10;
+        snprintf(line, sizeof(line), "Untracked: %lu", stats->untracked);
+        canvas_draw_str(canvas, 0, y, line);
+        y += 10;
+        snprintf(line, sizeof(line), "Free heap: %u B", memmgr_get_free_heap());
+        canvas_draw_str(canvas, 0, y, line);
+        break;
+    case 1:
+        futils_draw_header(canvas, "Per Operation", hs_model->page, 8);
+        for(uint8_t i = AtrackOpPress; i < AtrackOpCount; i++) {
+            const AtrackOpStats* op = &stats->ops[i];
+            snprintf(
+                line,
+                sizeof(line),
+                "%s: %lu/%luB pk%lu %+ld",
+                atrack_op_names[i],
+                op->count,
+                op->bytes,
+                op->peak_bytes,
+                op->leaked_bytes);
+            canvas_draw_str(canvas, 0, y, line);
+            y += 10;
+        }
+        break;
+    default: {
+        futils_draw_header(canvas, "Call Sites", hs_model->page, 8);
+        uint8_t first = (hs_model->page - 2) * HEAP_STATS_LINES;
+        for(uint8_t i = first; i < stats->site_count && i < first + HEAP_STATS_LINES; i++) {
+            const AtrackSiteStats* site = &stats->sites[i];
+            snprintf(
+                line,
+                sizeof(line),
+                "%.12s %lu %lu/%lu",
+                site->name,
+                site->count,
+                site->live_bytes,
+                site->peak_bytes);
+            canvas_draw_str(canvas, 0, y, line);
+            y += 10;
+        }
+        break;
+    }
+    }
+}
+
+/**
+ * @brief      Callback for heap stats screen input.
+ * @details    Left/Right change page, Ok refreshes the snapshot.
+ * @param      event    The event - InputEvent object.
+ * @param      context  The context - App object.
+ * @return     true if the event was handled, false otherwise.
+*/
+bool heap_stats_input_callback(InputEvent* event, void* context) {
+    App* app = (App*)context;
+    if(event->type != InputTypeShort) {
+        return false;
+    }
+
+    bool consumed = true;
+    with_view_model(
+        app->view_heap_stats,
+        HeapStatsModel * model,
+        {
+            switch(event->key) {
+            case InputKeyLeft:
+                if(model->page > 0) {
+                    model->page--;
+                }
+                break;
+            case InputKeyRight:
+                if(model->page + 1 < heap_stats_page_count(&model->stats)) {
+                    model->page++;
+                }
+                break;
+            case InputKeyOk:
+                atrack_get_stats(&model->stats);
+                break;
+            default:
+                consumed = false;
+                break;
+            }
+        },
+        consumed);
+    return consumed;
+}
+#endif
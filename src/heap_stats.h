@@ -0,0 +1,15 @@
+#pragma once
+#include "app.h"
+
+#if ALLOC_TRACKER
+#define HEAP_STATS_LINES 5
+
+typedef struct {
+    AtrackStats stats;
+    uint8_t page;
+} HeapStatsModel;
+
+void heap_stats_enter_callback(void* context);
+void heap_stats_draw_callback(Canvas* canvas, void* model);
+bool heap_stats_input_callback(InputEvent* event, void* context);
+#endif
@@ -0,0 +1,86 @@
+#include "macro.h"
+#include "bthome.h"
+#include "command.h"
+#include "libs/furi_utils.h"
+#include <furi_hal.h>
+
+#define MACRO_TAG "MACRO"
+
+_Static_assert(MACRO_PACKET_SIZE == EXTRA_BEACON_MAX_DATA_SIZE, "Macro packet size mismatch");
+
+/**
+ * @brief      Parse one macro line: <event> <button> <delay_ms> [repeat]
+ * @details    Empty lines and lines starting with # are skipped.
+ * @param      line  null terminated line, modified in place
+ * @param      step  filled on success
+ * @return     true if a step was parsed
+*/
+static bool macro_parse_line(char* line, MacroStep* step) {
+    while(*line == ' ' || *line == '\t') {
+        line++;
+    }
+    if(*line == '\0' || *line == '#') {
+        return false;
+    }
+
+    char* end = line;
+    while(*end && *end != ' ' && *end != '\t') {
+        end++;
+    }
+    if(*end == '\0') {
+        FURI_LOG_E(MACRO_TAG, "Missing fields in line: %s", line);
+        return false;
+    }
+    *end++ = '\0';
+
+    if(!cmd_event_from_name(line, &step->event)) {
+        FURI_LOG_E(MACRO_TAG, "Unknown event: %s", line);
+        return false;
+    }
+
+    char* next;
+    step->button = strtoul(end, &next, 10);
+    if(next == end) {
+        FURI_LOG_E(MACRO_TAG, "Missing button index");
+        return false;
+    }
+    end = next;
+    step->delay_ticks = furi_ms_to_ticks(strtoul(end, &next, 10));
+    if(next == end) {
+        FURI_LOG_E(MACRO_TAG, "Missing delay");
+        return false;
+    }
+    end = next;
+    step->repeat = strtoul(end, &next, 10);
+    if(next == end || step->repeat == 0) {
+        step->repeat = 1;
+    }
+    return true;
+}
+
+static bool macro_line_callback(char* line, void* context) {
+    Macro* macro = (Macro*)context;
+    if(macro_parse_line(line, &macro->steps[macro->step_count])) {
+        macro->step_count++;
+    }
+    return macro->step_count < MACRO_MAX_STEPS;
+}
+
+/**
+ * @brief      Load the macro steps from file, packets are built separately.
+ * @param      macro  the Macro object
+ * @param      path   the macro file path
+ * @return     true if at least one step was loaded
+*/
+bool macro_load(Macro* macro, const char* path) {
+    char line[MACRO_LINE_SIZE];
+
+    macro->step_count = 0;
+    if(!futils_read_lines(path, line, sizeof(line), macro_line_callback, macro)) {
+        FURI_LOG_I(MACRO_TAG, "No macro file %s", path);
+    }
+
+    macro->loaded = macro->step_count > 0;
+    FURI_LOG_I(MACRO_TAG, "Loaded %u steps", macro->step_count);
+    return macro->loaded;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+// Timed sequences of button events. The file is read by macro.c, the playback in macro_play.c
+// has no furi dependency so it can be driven on a virtual clock.
+
+#define MACRO_FILE_NAME   "macro.txt"
+#define MACRO_MAX_STEPS   16
+#define MACRO_LINE_SIZE   48
+#define MACRO_PACKET_SIZE 31 // EXTRA_BEACON_MAX_DATA_SIZE
+
+typedef struct {
+    uint8_t packet[MACRO_PACKET_SIZE]; // Pre-built, only the packet id is patched
+    uint8_t size;
+    uint8_t id_offset;
+    uint8_t button;
+    uint8_t event;
+    uint16_t repeat;
+    uint32_t delay_ticks; // Wait before each send of the step
+} MacroStep;
+
+typedef struct {
+    MacroStep steps[MACRO_MAX_STEPS];
+    uint8_t step_count;
+    bool loaded;
+    // Playback, owned by the comm worker
+    volatile bool running;
+    uint8_t curr_step;
+    uint16_t curr_repeat;
+    uint32_t due_tick;
+    uint32_t max_late_ticks;
+} Macro;
+
+bool macro_load(Macro* macro, const char* path);
+void macro_start(Macro* macro, uint32_t now);
+void macro_stop(Macro* macro);
+bool macro_get_due(const Macro* macro, uint32_t* due);
+MacroStep* macro_next(Macro* macro, uint32_t now);
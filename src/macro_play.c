@@ -0,0 +1,58 @@
+#include "macro.h"
+#include <stddef.h>
+
+/**
+ * @brief      Start the playback from the first step.
+ * @param      now  current tick
+*/
+void macro_start(Macro* macro, uint32_t now) {
+    if(!macro->loaded) return;
+    macro->curr_step = 0;
+    macro->curr_repeat = 0;
+    macro->max_late_ticks = 0;
+    macro->due_tick = now + macro->steps[0].delay_ticks;
+    macro->running = true;
+}
+
+void macro_stop(Macro* macro) {
+    macro->running = false;
+}
+
+/**
+ * @brief      When the next step is due.
+ * @param      due  filled with the tick of the next step
+ * @return     false if the macro is not running
+*/
+bool macro_get_due(const Macro* macro, uint32_t* due) {
+    if(!macro->running) return false;
+    *due = macro->due_tick;
+    return true;
+}
+
+/**
+ * @brief      Get the step due now and schedule the following one.
+ * @details    The schedule is absolute from the start tick, so lateness of a step does not
+ *             delay the following ones.
+ * @param      now  current tick
+ * @return     the step to send, NULL if nothing is due
+*/
+MacroStep* macro_next(Macro* macro, uint32_t now) {
+    if(!macro->running || (int32_t)(now - macro->due_tick) < 0) {
+        return NULL;
+    }
+    MacroStep* step = &macro->steps[macro->curr_step];
+    const uint32_t late = now - macro->due_tick;
+    if(late > macro->max_late_ticks) {
+        macro->max_late_ticks = late;
+    }
+
+    if(++macro->curr_repeat >= step->repeat) {
+        macro->curr_repeat = 0;
+        if(++macro->curr_step >= macro->step_count) {
+            macro->running = false;
+            return step;
+        }
+    }
+    macro->due_tick += macro->steps[macro->curr_step].delay_ticks;
+    return step;
+}
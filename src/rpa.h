@@ -0,0 +1,22 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+// Resolvable private addresses (BLE Core Spec Vol 6 Part B 1.3.2.2).
+// It has no furi dependency, the caller provides the random part.
+
+#define RPA_IRK_SIZE   16
+#define RPA_ADDR_SIZE  6
+#define RPA_HASH_SIZE  3
+#define RPA_ROUND_KEYS 176
+
+typedef struct {
+    uint8_t irk[RPA_IRK_SIZE]; // MSB first, as shown to the resolver
+    uint8_t round_keys[RPA_ROUND_KEYS]; // AES-128 key expansion of the IRK
+    bool ready;
+} Rpa;
+
+void rpa_set_irk(Rpa* rpa, const uint8_t irk[RPA_IRK_SIZE]);
+void rpa_ah(const Rpa* rpa, const uint8_t prand[RPA_HASH_SIZE], uint8_t hash[RPA_HASH_SIZE]);
+bool rpa_generate(Rpa* rpa, const uint8_t random[RPA_HASH_SIZE], uint8_t address[RPA_ADDR_SIZE]);
+bool rpa_resolve(const Rpa* rpa, const uint8_t address[RPA_ADDR_SIZE]);
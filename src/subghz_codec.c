@@ -0,0 +1,85 @@
+#include "subghz_codec.h"
+#include <stddef.h>
+#include <strings.h>
+
+static const char* const subghz_proto_names[SubghzProtoCount] = {"Princeton", "CAME"};
+
+const char* subghz_codec_proto_name(uint8_t proto) {
+    return proto < SubghzProtoCount ? subghz_proto_names[proto] : "?";
+}
+
+bool subghz_codec_proto_from_name(const char* name, uint8_t* proto) {
+    for(uint8_t i = 0; i < SubghzProtoCount; i++) {
+        if(strcasecmp(name, subghz_proto_names[i]) == 0) {
+            *proto = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief      Princeton (PT2262 style): every bit is high then low, 3:1 for a 1 and 1:3 for a
+ *             0, the frame ends with a 1:30 sync.
+*/
+static void subghz_codec_princeton(const SubghzKey* key, SubghzWave* wave) {
+    const int32_t te = SUBGHZ_PRINCETON_TE;
+    for(int8_t i = key->bits - 1; i >= 0; i--) {
+        const bool bit = (key->key >> i) & 1;
+        wave->timings[wave->count++] = bit ? te * 3 : te;
+        wave->timings[wave->count++] = bit ? -te : -te * 3;
+    }
+    wave->timings[wave->count++] = te;
+    wave->timings[wave->count++] = -te * 30;
+}
+
+/**
+ * @brief      CAME: a long low header and a short start pulse, then every bit is low then high,
+ *             long:short for a 1 and short:long for a 0.
+*/
+static void subghz_codec_came(const SubghzKey* key, SubghzWave* wave) {
+    const int32_t te_short = SUBGHZ_CAME_TE_SHORT;
+    const int32_t te_long = SUBGHZ_CAME_TE_LONG;
+    wave->timings[wave->count++] = -te_short * 36;
+    wave->timings[wave->count++] = te_short;
+    for(int8_t i = key->bits - 1; i >= 0; i--) {
+        const bool bit = (key->key >> i) & 1;
+        wave->timings[wave->count++] = bit ? -te_long : -te_short;
+        wave->timings[wave->count++] = bit ? te_short : te_long;
+    }
+}
+
+/**
+ * @brief      Build the timings of one frame of a key, repeats are left to the transmitter.
+ * @param      key   The key to encode.
+ * @param      wave  Filled with the frame.
+ * @return     false if the protocol or the bit count is not supported
+*/
+bool subghz_codec_encode(const SubghzKey* key, SubghzWave* wave) {
+    wave->count = 0;
+    if(key->bits == 0 || key->bits > SUBGHZ_CODE_MAX_BITS) {
+        return false;
+    }
+    switch(key->proto) {
+    case SubghzProtoPrinceton:
+        subghz_codec_princeton(key, wave);
+        return true;
+    case SubghzProtoCame:
+        subghz_codec_came(key, wave);
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief      Air time of one frame.
+ * @return     the frame length in us
+*/
+uint32_t subghz_codec_wave_us(const SubghzWave* wave) {
+    uint32_t us = 0;
+    for(size_t i = 0; i < wave->count; i++) {
+        us += wave->timings[i] > 0 ? wave->timings[i] : -wave->timings[i];
+    }
+    return us;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+// OOK encoders of static Sub-GHz codes, e.g. Princeton and CAME remotes.
+// It has no furi dependency so the timings can be checked from a host build.
+
+#define SUBGHZ_CODE_MAX_BITS 32
+// A frame is two durations per bit plus the sync/header pair
+#define SUBGHZ_WAVE_MAX      (SUBGHZ_CODE_MAX_BITS * 2 + 2)
+
+#define SUBGHZ_PRINCETON_TE      390 // us
+#define SUBGHZ_CAME_TE_SHORT     320
+#define SUBGHZ_CAME_TE_LONG      640
+#define SUBGHZ_DEFAULT_FREQUENCY 433920000
+
+typedef enum {
+    SubghzProtoPrinceton,
+    SubghzProtoCame,
+    SubghzProtoCount,
+} SubghzProto;
+
+typedef struct {
+    uint8_t proto;
+    uint8_t bits;
+    uint32_t key;
+    uint32_t frequency; // Hz
+} SubghzKey;
+
+typedef struct {
+    int32_t timings[SUBGHZ_WAVE_MAX]; // us, positive is carrier on, negative is off
+    uint8_t count;
+} SubghzWave;
+
+const char* subghz_codec_proto_name(uint8_t proto);
+bool subghz_codec_proto_from_name(const char* name, uint8_t* proto);
+bool subghz_codec_encode(const SubghzKey* key, SubghzWave* wave);
+uint32_t subghz_codec_wave_us(const SubghzWave* wave);
@@ -0,0 +1,251 @@
+#include "subghz_mirror.h"
+#include "libs/furi_utils.h"
+#include <lib/subghz/devices/cc1101_int/cc1101_int_interconnect.h>
+
+#define SUBGHZ_MIRROR_TAG "SUBGHZ_MIRROR"
+
+/**
+ * @brief      Parse one key line: <button> <protocol> <bits> <key hex> [frequency Hz]
+ * @details    Empty lines and lines starting with # are skipped.
+ * @param      line  null terminated line
+ * @param      key   filled on success
+ * @return     true if a key was parsed
+*/
+static bool subghz_mirror_parse_line(char* line, SubghzMirrorKey* key) {
+    while(*line == ' ' || *line == '\t') {
+        line++;
+    }
+    if(*line == '\0' || *line == '#') {
+        return false;
+    }
+
+    char* next;
+    key->button = strtoul(line, &next, 10);
+    if(next == line) {
+        FURI_LOG_E(SUBGHZ_MIRROR_TAG, "Missing button index: %s", line);
+        return false;
+    }
+    line = next;
+    while(*line == ' ' || *line == '\t') {
+        line++;
+    }
+    char* end = line;
+    while(*end && *end != ' ' && *end != '\t') {
+        end++;
+    }
+    if(*end == '\0') {
+        FURI_LOG_E(SUBGHZ_MIRROR_TAG, "Missing fields after the protocol");
+        return false;
+    }
+    *end++ = '\0';
+    if(!subghz_codec_proto_from_name(line, &key->key.proto)) {
+        FURI_LOG_E(SUBGHZ_MIRROR_TAG, "Unknown protocol: %s", line);
+        return false;
+    }
+
+    line = end;
+    key->key.bits = strtoul(line, &next, 10);
+    if(next == line) {
+        FURI_LOG_E(SUBGHZ_MIRROR_TAG, "Missing bit count");
+        return false;
+    }
+    line = next;
+    key->key.key = strtoul(line, &next, 16);
+    if(next == line) {
+        FURI_LOG_E(SUBGHZ_MIRROR_TAG, "Missing key");
+        return false;
+    }
+    line = next;
+    key->key.frequency = strtoul(line, &next, 10);
+    if(next == line) {
+        key->key.frequency = SUBGHZ_DEFAULT_FREQUENCY;
+    }
+    if(!furi_hal_region_is_frequency_allowed(key->key.frequency)) {
+        FURI_LOG_E(
+            SUBGHZ_MIRROR_TAG, "Frequency %lu not allowed in this region", key->key.frequency);
+        return false;
+    }
+    if(!subghz_codec_encode(&key->key, &key->wave)) {
+        FURI_LOG_E(SUBGHZ_MIRROR_TAG, "Unsupported bit count: %u", key->key.bits);
+        return false;
+    }
+    return true;
+}
+
+static bool subghz_mirror_line_callback(char* line, void* context) {
+    SubghzMirror* mirror = (SubghzMirror*)context;
+    if(subghz_mirror_parse_line(line, &mirror->keys[mirror->key_count])) {
+        mirror->key_count++;
+    }
+    return mirror->key_count < SUBGHZ_MIRROR_MAX_KEYS;
+}
+
+/**
+ * @brief      Load the keys from file and build their timings.
+ * @param      mirror  the SubghzMirror object
+ * @param      path    the key file path
+ * @return     true if at least one key was loaded
+*/
+bool subghz_mirror_load(SubghzMirror* mirror, const char* path) {
+    char line[SUBGHZ_MIRROR_LINE_SIZE];
+
+    mirror->key_count = 0;
+    if(!futils_read_lines(path, line, sizeof(line), subghz_mirror_line_callback, mirror)) {
+        FURI_LOG_I(SUBGHZ_MIRROR_TAG, "No key file %s", path);
+    }
+    FURI_LOG_I(SUBGHZ_MIRROR_TAG, "Loaded %u keys", mirror->key_count);
+    return mirror->key_count > 0;
+}
+
+/**
+ * @brief      The key mirrored by a button.
+ * @return     the key, NULL if the button has none
+*/
+const SubghzMirrorKey* subghz_mirror_find(const SubghzMirror* mirror, uint8_t button) {
+    for(uint8_t i = 0; i < mirror->key_count; i++) {
+        if(mirror->keys[i].button == button) {
+            return &mirror->keys[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief      Async TX callback, runs in interrupt context.
+ * @details    Only walks the pre-built timings, the frame is repeated SUBGHZ_MIRROR_REPEAT times.
+*/
+static LevelDuration subghz_mirror_tx_callback(void* context) {
+    SubghzMirror* mirror = (SubghzMirror*)context;
+    const SubghzWave* wave = &mirror->tx_key->wave;
+    if(mirror->tx_pos >= wave->count) {
+        if(++mirror->tx_repeat >= SUBGHZ_MIRROR_REPEAT) {
+            return level_duration_reset();
+        }
+        mirror->tx_pos = 0;
+    }
+    const int32_t timing = wave->timings[mirror->tx_pos++];
+    return level_duration_make(timing > 0, timing > 0 ? timing : -timing);
+}
+
+static void subghz_mirror_tx_failed(SubghzMirror* mirror, const SubghzMirrorKey* key) {
+    mirror->tx_errors++;
+    FURI_LOG_E(
+        SUBGHZ_MIRROR_TAG,
+        "TX of %s %lX at %lu failed",
+        subghz_codec_proto_name(key->key.proto),
+        key->key.key,
+        key->key.frequency);
+}
+
+/**
+ * @brief      Stop the running transmission and put the radio back to idle.
+ * @details    It counts as sent once a whole frame is on air, a newer event may cut the repeats.
+*/
+static void subghz_mirror_tx_end(SubghzMirror* mirror) {
+    subghz_devices_stop_async_tx(mirror->device);
+    subghz_devices_idle(mirror->device);
+    mirror->tx_busy = false;
+    if(mirror->tx_repeat > 0) {
+        mirror->tx_count++;
+    } else {
+        subghz_mirror_tx_failed(mirror, mirror->tx_key);
+    }
+}
+
+/**
+ * @brief      Prepare the internal CC1101 for the transmissions, once when the mirror is enabled.
+ * @param      mirror  the SubghzMirror object
+ * @return     true if the radio is ready
+*/
+bool subghz_mirror_open(SubghzMirror* mirror) {
+    if(mirror->device) {
+        return true;
+    }
+    subghz_devices_init();
+    const SubGhzDevice* device = subghz_devices_get_by_name(SUBGHZ_DEVICE_CC1101_INT_NAME);
+    if(!device || !subghz_devices_begin(device)) {
+        subghz_devices_deinit();
+        FURI_LOG_E(SUBGHZ_MIRROR_TAG, "CC1101 not available");
+        return false;
+    }
+    subghz_devices_reset(device);
+    subghz_devices_load_preset(device, FuriHalSubGhzPresetOok650Async, NULL);
+    subghz_devices_idle(device);
+    mirror->device = device;
+    mirror->tx_frequency = 0;
+    FURI_LOG_I(SUBGHZ_MIRROR_TAG, "CC1101 ready");
+    return true;
+}
+
+/**
+ * @brief      Release the CC1101, a running transmission is stopped.
+ * @param      mirror  the SubghzMirror object
+*/
+void subghz_mirror_close(SubghzMirror* mirror) {
+    if(!mirror->device) {
+        return;
+    }
+    if(mirror->tx_busy) {
+        subghz_mirror_tx_end(mirror);
+    }
+    subghz_devices_sleep(mirror->device);
+    subghz_devices_end(mirror->device);
+    subghz_devices_deinit();
+    mirror->device = NULL;
+    FURI_LOG_I(SUBGHZ_MIRROR_TAG, "CC1101 released");
+}
+
+/**
+ * @brief      Start the transmission of a key on the prepared CC1101, returns without waiting.
+ * @details    The frames go out in the background, subghz_mirror_poll() ends the transmission.
+ *             A transmission still running is cut first.
+ * @param      mirror  the SubghzMirror object
+ * @param      key     the key to send
+ * @return     true if the transmission started
+*/
+bool subghz_mirror_send(SubghzMirror* mirror, const SubghzMirrorKey* key) {
+    if(!mirror->device) {
+        subghz_mirror_tx_failed(mirror, key);
+        return false;
+    }
+    if(mirror->tx_busy) {
+        subghz_mirror_tx_end(mirror);
+    }
+    if(key->key.frequency != mirror->tx_frequency) {
+        if(!subghz_devices_is_frequency_valid(mirror->device, key->key.frequency)) {
+            subghz_mirror_tx_failed(mirror, key);
+            return false;
+        }
+        subghz_devices_set_frequency(mirror->device, key->key.frequency);
+        mirror->tx_frequency = key->key.frequency;
+    }
+    mirror->tx_key = key;
+    mirror->tx_pos = 0;
+    mirror->tx_repeat = 0;
+    if(!subghz_devices_start_async_tx(mirror->device, subghz_mirror_tx_callback, mirror)) {
+        subghz_mirror_tx_failed(mirror, key);
+        return false;
+    }
+    const uint32_t air_ms = subghz_codec_wave_us(&key->wave) * SUBGHZ_MIRROR_REPEAT / 1000;
+    mirror->tx_timeout = furi_ms_to_ticks(air_ms + SUBGHZ_MIRROR_MARGIN);
+    mirror->tx_start = furi_get_tick();
+    mirror->tx_busy = true;
+    return true;
+}
+
+/**
+ * @brief      End the transmission once its frames are on air or it timed out.
+ * @param      mirror  the SubghzMirror object
+ * @return     true while the transmission is running, poll again SUBGHZ_MIRROR_POLL ms later
+*/
+bool subghz_mirror_poll(SubghzMirror* mirror) {
+    if(!mirror->tx_busy) {
+        return false;
+    }
+    if(!subghz_devices_is_async_complete_tx(mirror->device) &&
+       furi_get_tick() - mirror->tx_start < mirror->tx_timeout) {
+        return true;
+    }
+    subghz_mirror_tx_end(mirror);
+    return false;
+}
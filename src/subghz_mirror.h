@@ -0,0 +1,41 @@
+#pragma once
+#include <furi.h>
+#include <furi_hal.h>
+#include <lib/subghz/devices/devices.h>
+#include "subghz_codec.h"
+
+#define SUBGHZ_MIRROR_FILE_NAME "subghz.txt"
+#define SUBGHZ_MIRROR_MAX_KEYS  8
+#define SUBGHZ_MIRROR_LINE_SIZE 48
+#define SUBGHZ_MIRROR_REPEAT    10 // Frames per event, receivers want a few in a row
+#define SUBGHZ_MIRROR_MARGIN    100U // ms over the expected air time before giving up
+#define SUBGHZ_MIRROR_POLL      10U // ms between checks of the end of a transmission
+
+typedef struct {
+    SubghzKey key;
+    SubghzWave wave; // Pre-built when the file is loaded, never encoded on a press
+    uint8_t button;
+} SubghzMirrorKey;
+
+typedef struct {
+    SubghzMirrorKey keys[SUBGHZ_MIRROR_MAX_KEYS];
+    uint8_t key_count;
+    // Radio and transmission, owned by the comm worker
+    const SubGhzDevice* device; // Prepared while the mirror is enabled, NULL otherwise
+    uint32_t tx_frequency;
+    const SubghzMirrorKey* tx_key;
+    bool tx_busy;
+    uint32_t tx_start;
+    uint32_t tx_timeout;
+    uint8_t tx_pos;
+    uint8_t tx_repeat;
+    uint32_t tx_count;
+    uint32_t tx_errors;
+} SubghzMirror;
+
+bool subghz_mirror_load(SubghzMirror* mirror, const char* path);
+const SubghzMirrorKey* subghz_mirror_find(const SubghzMirror* mirror, uint8_t button);
+bool subghz_mirror_open(SubghzMirror* mirror);
+void subghz_mirror_close(SubghzMirror* mirror);
+bool subghz_mirror_send(SubghzMirror* mirror, const SubghzMirrorKey* key);
+bool subghz_mirror_poll(SubghzMirror* mirror);
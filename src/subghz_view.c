@@ -0,0 +1,125 @@
+#include "subghz_view.h"
+#include "libs/furi_utils.h"
+
+/**
+ * @brief      Number of pages: status and then the keys.
+*/
+static uint8_t subghz_view_page_count(const SubghzViewModel* model) {
+    return 1 + (model->key_count + SUBGHZ_VIEW_LINES - 1) / SUBGHZ_VIEW_LINES;
+}
+
+static void subghz_view_snapshot(App* app, SubghzViewModel* model) {
+    BtBeacon* bt_model = view_get_model(app->view_bt);
+    const SubghzMirror* mirror = bt_model->subghz;
+    model->enabled = bt_model->subghz_mirror_enb;
+    model->key_count = mirror->key_count;
+    for(uint8_t i = 0; i < mirror->key_count; i++) {
+        model->keys[i] = mirror->keys[i].key;
+        model->buttons[i] = mirror->keys[i].button;
+    }
+    model->tx_count = mirror->tx_count;
+    model->tx_errors = mirror->tx_errors;
+    if(model->page >= subghz_view_page_count(model)) {
+        model->page = 0;
+    }
+}
+
+/**
+ * @brief      Callback of the Sub-GHz screen on enter.
+ * @details    Take a snapshot of the keys and of the counters.
+ * @param      context  The context - App object.
+*/
+void subghz_view_enter_callback(void* context) {
+    App* app = (App*)context;
+    with_view_model(
+        app->view_sghz, SubghzViewModel * model, { subghz_view_snapshot(app, model); }, true);
+}
+
+/**
+ * @brief      Callback for drawing the Sub-GHz screen.
+ * @param      canvas  The canvas to draw on.
+ * @param      model   The model - SubghzViewModel object.
+*/
+void subghz_view_draw_callback(Canvas* canvas, void* model) {
+    SubghzViewModel* sg_model = (SubghzViewModel*)model;
+    char line[32];
+    int32_t y = 18;
+
+    canvas_clear(canvas);
+    if(sg_model->page == 0) {
+        futils_draw_header(canvas, "Sub-GHz Mirror", sg_model->page, 8);
+        snprintf(line, sizeof(line), "Mirror: %s", sg_model->enabled ? "On" : "Off");
+        canvas_draw_str(canvas, 0, y, line);
+        y += 10;
+        snprintf(line, sizeof(line), "Keys: %u", sg_model->key_count);
+        canvas_draw_str(canvas, 0, y, line);
+        y += 10;
+        snprintf(line, sizeof(line), "Sent: %lu", sg_model->tx_count);
+        canvas_draw_str(canvas, 0, y, line);
+        y += 10;
+        snprintf(line, sizeof(line), "Errors: %lu", sg_model->tx_errors);
+        canvas_draw_str(canvas, 0, y, line);
+        if(sg_model->key_count == 0) {
+            canvas_draw_str(canvas, 0, y + 10, "Add keys in " SUBGHZ_MIRROR_FILE_NAME);
+        }
+        return;
+    }
+
+    futils_draw_header(canvas, "Keys", sg_model->page, 8);
+    uint8_t first = (sg_model->page - 1) * SUBGHZ_VIEW_LINES;
+    for(uint8_t i = first; i < sg_model->key_count && i < first + SUBGHZ_VIEW_LINES; i++) {
+        const SubghzKey* key = &sg_model->keys[i];
+        snprintf(
+            line,
+            sizeof(line),
+            "B%u %.5s %lX %lu.%02lu",
+            sg_model->buttons[i],
+            subghz_codec_proto_name(key->proto),
+            key->key,
+            key->frequency / 1000000,
+            key->frequency % 1000000 / 10000);
+        canvas_draw_str(canvas, 0, y, line);
+        y += 10;
+    }
+}
+
+/**
+ * @brief      Callback for Sub-GHz screen input.
+ * @details    Left/Right change page, Ok refreshes the snapshot.
+ * @param      event    The event - InputEvent object.
+ * @param      context  The context - App object.
+ * @return     true if the event was handled, false otherwise.
+*/
+bool subghz_view_input_callback(InputEvent* event, void* context) {
+    App* app = (App*)context;
+    if(event->type != InputTypeShort) {
+        return false;
+    }
+
+    bool consumed = true;
+    with_view_model(
+        app->view_sghz,
+        SubghzViewModel * model,
+        {
+            switch(event->key) {
+            case InputKeyLeft:
+                if(model->page > 0) {
+                    model->page--;
+                }
+                break;
+            case InputKeyRight:
+                if(model->page + 1 < subghz_view_page_count(model)) {
+                    model->page++;
+                }
+                break;
+            case InputKeyOk:
+                subghz_view_snapshot(app, model);
+                break;
+            default:
+                consumed = false;
+                break;
+            }
+        },
+        consumed);
+    return consumed;
+}
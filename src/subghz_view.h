@@ -0,0 +1,18 @@
+#pragma once
+#include "app.h"
+
+#define SUBGHZ_VIEW_LINES 5
+
+typedef struct {
+    bool enabled;
+    uint8_t key_count;
+    SubghzKey keys[SUBGHZ_MIRROR_MAX_KEYS];
+    uint8_t buttons[SUBGHZ_MIRROR_MAX_KEYS];
+    uint32_t tx_count;
+    uint32_t tx_errors;
+    uint8_t page;
+} SubghzViewModel;
+
+void subghz_view_enter_callback(void* context);
+void subghz_view_draw_callback(Canvas* canvas, void* model);
+bool subghz_view_input_callback(InputEvent* event, void* context);
@@ -0,0 +1,293 @@
+#include "tx_log.h"
+#include "app.h"
+#include <storage/storage.h>
+
+#define TX_LOG_TAG "TX_LOG"
+
+typedef enum {
+    TxLogEventStop = 1 << 0,
+    TxLogEventFlush = 1 << 1,
+} TxLogEvent;
+
+struct TxLog {
+    FuriThread* thread;
+    FuriThreadId thread_id;
+    const char* log_path;
+    const char* index_path;
+    // Single producer, single consumer: head is only moved by the comm worker, tail by the
+    // flusher. A barrier orders the slot accesses against the index move that hands them over
+    TxLogRecord ring[TX_LOG_RING_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t dropped; // Ring full or write failed, added to by both threads
+    // Owned by the flusher
+    uint32_t records; // Already in the log file
+    TxLogDay day; // Last entry of the index
+    uint32_t day_count; // Entries in the index
+};
+
+static uint32_t tx_log_day(const TxLogRecord* record) {
+    return record->timestamp / (60 * 60 * 24);
+}
+
+/**
+ * @brief      Size of a file in records, 0 if it doesn't exist.
+*/
+static uint32_t tx_log_file_count(Storage* storage, const char* path, size_t record_size) {
+    File* file = storage_file_alloc(storage);
+    uint32_t count = 0;
+    if(storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        count = storage_file_size(file) / record_size;
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    return count;
+}
+
+/**
+ * @brief      Find where the log and the index end, and load the last day of the index.
+*/
+static void tx_log_open(TxLog* log) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    log->records = tx_log_file_count(storage, log->log_path, sizeof(TxLogRecord));
+    log->day_count = tx_log_file_count(storage, log->index_path, sizeof(TxLogDay));
+    furi_record_close(RECORD_STORAGE);
+    if(log->day_count == 0 || tx_log_read_days(log->index_path, 0, &log->day, 1) == 0) {
+        memset(&log->day, 0, sizeof(TxLogDay));
+        log->day_count = 0;
+    }
+    FURI_LOG_I(TX_LOG_TAG, "%lu records, %lu days", log->records, log->day_count);
+}
+
+/**
+ * @brief      Account a record in the index, a new day gets a new entry.
+*/
+static void tx_log_index_add(TxLog* log, const TxLogRecord* record, uint32_t position) {
+    const uint32_t day = tx_log_day(record);
+    if(log->day_count == 0 || day > log->day.day) {
+        memset(&log->day, 0, sizeof(TxLogDay));
+        log->day.day = day;
+        log->day.first = position;
+        log->day_count++;
+    }
+    log->day.count++;
+    // Only button events have a button
+    if(record->kind == BtPacketButton && record->button < TX_LOG_BUTTONS) {
+        log->day.buttons[record->button]++;
+    }
+}
+
+/**
+ * @brief      Write the current entry of the index in place.
+*/
+static void tx_log_index_write(TxLog* log, File* file) {
+    const uint32_t offset = (log->day_count - 1) * sizeof(TxLogDay);
+    if(!storage_file_seek(file, offset, true) ||
+       storage_file_write(file, &log->day, sizeof(TxLogDay)) != sizeof(TxLogDay)) {
+        FURI_LOG_E(TX_LOG_TAG, "Error writing the index");
+    }
+}
+
+/**
+ * @brief      Bring the log back to whole records after a failed or short write.
+ * @details    A partial record is cut, otherwise every later record and index entry would point
+ *             at the wrong offset. The records are counted again from the file size.
+ * @param      log   the TxLog object
+ * @param      file  the log file, open for writing
+ * @return     the records in the log file
+*/
+static uint32_t tx_log_write_failed(TxLog* log, File* file) {
+    FURI_LOG_E(TX_LOG_TAG, "Error writing %s", log->log_path);
+    const uint64_t size = storage_file_size(file);
+    const uint32_t records = size / sizeof(TxLogRecord);
+    if(size % sizeof(TxLogRecord) != 0 &&
+       (!storage_file_seek(file, records * sizeof(TxLogRecord), true) ||
+        !storage_file_truncate(file))) {
+        FURI_LOG_E(TX_LOG_TAG, "Error cutting the partial record");
+    }
+    return records;
+}
+
+/**
+ * @brief      Append the waiting records to the log and update the index.
+ * @param      log  the TxLog object
+ * @param      all  false to write whole blocks only
+*/
+static void tx_log_flush(TxLog* log, bool all) {
+    uint32_t pending = log->head - log->tail;
+    if(pending == 0 || (!all && pending < TX_LOG_BLOCK)) {
+        return;
+    }
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    File* index = storage_file_alloc(storage);
+    TxLogRecord block[TX_LOG_BLOCK];
+
+    if(storage_file_open(file, log->log_path, FSAM_WRITE, FSOM_OPEN_APPEND) &&
+       storage_file_open(index, log->index_path, FSAM_WRITE, FSOM_OPEN_ALWAYS)) {
+        while(pending >= TX_LOG_BLOCK || (all && pending > 0)) {
+            const uint32_t count = MIN(pending, (uint32_t)TX_LOG_BLOCK);
+            // The records are read after the head that published them
+            __DMB();
+            for(uint32_t i = 0; i < count; i++) {
+                block[i] = log->ring[(log->tail + i) % TX_LOG_RING_SIZE];
+            }
+
+            const size_t size = count * sizeof(TxLogRecord);
+            const bool written = storage_file_write(file, block, size) == size;
+            const uint32_t in_file =
+                written ? log->records + count : tx_log_write_failed(log, file);
+            const uint32_t done = in_file > log->records ? MIN(in_file - log->records, count) : 0;
+            // The slots are handed back once written, or counted as dropped
+            __DMB();
+            log->tail += count;
+            pending -= count;
+
+            for(uint32_t i = 0; i < done; i++) {
+                if(log->day_count > 0 && tx_log_day(&block[i]) > log->day.day) {
+                    // Close the previous day before starting the new entry
+                    tx_log_index_write(log, index);
+                }
+                tx_log_index_add(log, &block[i], log->records + i);
+            }
+            log->records = in_file;
+            if(done > 0) {
+                tx_log_index_write(log, index);
+            }
+            if(!written) {
+                __atomic_fetch_add(&log->dropped, count - done, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+    } else {
+        FURI_LOG_E(TX_LOG_TAG, "Error opening the log files");
+    }
+    storage_file_close(index);
+    storage_file_close(file);
+    storage_file_free(index);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+}
+
+static int32_t tx_log_worker(void* context) {
+    TxLog* log = (TxLog*)context;
+
+    while(true) {
+        uint32_t events = furi_thread_flags_wait(
+            TxLogEventStop | TxLogEventFlush,
+            FuriFlagWaitAny,
+            furi_ms_to_ticks(TX_LOG_FLUSH_PERIOD));
+        if(events & FuriFlagError) {
+            // Nothing for a while, write what is left
+            tx_log_flush(log, true);
+            continue;
+        }
+        if(events & TxLogEventStop) {
+            break;
+        }
+        tx_log_flush(log, false);
+    }
+    tx_log_flush(log, true);
+    return 0;
+}
+
+/**
+ * @brief      Open the log and start the flusher thread.
+ * @param      log_path    the log file path
+ * @param      index_path  the index file path
+ * @return     the TxLog object
+*/
+TxLog* tx_log_alloc(const char* log_path, const char* index_path) {
+    TxLog* log = ATRACK_MALLOC(sizeof(TxLog));
+    memset(log, 0, sizeof(TxLog));
+    log->log_path = log_path;
+    log->index_path = index_path;
+    tx_log_open(log);
+
+    log->thread = furi_thread_alloc_ex("TxLogFlusher", 1024, tx_log_worker, log);
+    furi_thread_set_priority(log->thread, FuriThreadPriorityLow);
+    furi_thread_start(log->thread);
+    log->thread_id = furi_thread_get_id(log->thread);
+    return log;
+}
+
+/**
+ * @brief      Write the records left and stop the flusher.
+ * @param      log  the TxLog object
+*/
+void tx_log_free(TxLog* log) {
+    furi_thread_flags_set(log->thread_id, TxLogEventStop);
+    furi_thread_join(log->thread);
+    furi_thread_free(log->thread);
+    if(log->dropped) {
+        FURI_LOG_W(TX_LOG_TAG, "%lu records dropped", log->dropped);
+    }
+    ATRACK_FREE(log);
+}
+
+/**
+ * @brief      Add a record to the RAM ring, never blocks.
+ * @details    Called from the comm worker only. When the ring is full the record is dropped.
+ * @param      log     the TxLog object
+ * @param      record  the record to add
+*/
+void tx_log_append(TxLog* log, const TxLogRecord* record) {
+    const uint32_t pending = log->head - log->tail;
+    if(pending >= TX_LOG_RING_SIZE) {
+        __atomic_fetch_add(&log->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    // The slot is free once the flusher moved the tail past it
+    __DMB();
+    log->ring[log->head % TX_LOG_RING_SIZE] = *record;
+    // The record lands before the flusher can see it
+    __DMB();
+    log->head++;
+    if(pending + 1 >= TX_LOG_BLOCK) {
+        furi_thread_flags_set(log->thread_id, TxLogEventFlush);
+    }
+}
+
+uint32_t tx_log_dropped(const TxLog* log) {
+    return log->dropped;
+}
+
+/**
+ * @brief      Number of days in the index.
+ * @param      index_path  the index file path
+*/
+uint32_t tx_log_day_count(const char* index_path) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    const uint32_t count = tx_log_file_count(storage, index_path, sizeof(TxLogDay));
+    furi_record_close(RECORD_STORAGE);
+    return count;
+}
+
+/**
+ * @brief      Read days from the index, newest first, without touching the log.
+ * @param      index_path  the index file path
+ * @param      skip        newest days to skip
+ * @param      days        filled with the days read
+ * @param      count       max days to read
+ * @return     the number of days read
+*/
+uint32_t tx_log_read_days(const char* index_path, uint32_t skip, TxLogDay* days, uint8_t count) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    uint32_t read = 0;
+    if(storage_file_open(file, index_path, FSAM_READ, FSOM_OPEN_EXISTING)) {
+        const uint32_t total = storage_file_size(file) / sizeof(TxLogDay);
+        while(read < count && skip + read < total) {
+            const uint32_t entry = total - 1 - skip - read;
+            if(!storage_file_seek(file, entry * sizeof(TxLogDay), true) ||
+               storage_file_read(file, &days[read], sizeof(TxLogDay)) != sizeof(TxLogDay)) {
+                break;
+            }
+            read++;
+        }
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    return read;
+}
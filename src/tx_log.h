@@ -0,0 +1,40 @@
+#pragma once
+#include <furi.h>
+#include <furi_hal.h>
+
+// Append-only log of the packets sent, as fixed size binary records, plus a per-day index.
+// The comm worker only appends to a RAM ring, a low priority thread writes it in blocks.
+
+#define TX_LOG_FILE_NAME    "tx_log.bin"
+#define TX_LOG_INDEX_NAME   "tx_log.idx"
+#define TX_LOG_RING_SIZE    64 // Records waiting for the flusher
+#define TX_LOG_BLOCK        16 // Records per write
+#define TX_LOG_FLUSH_PERIOD 60000U // ms, a partial block is written after this long
+#define TX_LOG_BUTTONS      5 // BT_HOME_BUTTON_COUNT
+
+typedef struct {
+    uint32_t timestamp; // RTC, s
+    uint16_t latency_ms; // From the request to the radio, 0 if not measured
+    uint8_t kind; // BtPacketKind
+    uint8_t button;
+    uint8_t event;
+    uint8_t profile;
+    uint8_t packet_id;
+    uint8_t reserved;
+} TxLogRecord;
+
+typedef struct {
+    uint32_t day; // Days since 1970
+    uint32_t first; // Index of the first record of the day in the log
+    uint32_t count;
+    uint16_t buttons[TX_LOG_BUTTONS]; // Button events per button
+} TxLogDay;
+
+typedef struct TxLog TxLog;
+
+TxLog* tx_log_alloc(const char* log_path, const char* index_path);
+void tx_log_free(TxLog* log);
+void tx_log_append(TxLog* log, const TxLogRecord* record);
+uint32_t tx_log_dropped(const TxLog* log);
+uint32_t tx_log_read_days(const char* index_path, uint32_t skip, TxLogDay* days, uint8_t count);
+uint32_t tx_log_day_count(const char* index_path);
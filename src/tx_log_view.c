@@ -0,0 +1,110 @@
+#include "tx_log_view.h"
+#include "libs/furi_utils.h"
+
+/**
+ * @brief      Read the days of the current page from the index, the log itself is not read.
+*/
+static void tx_log_view_load(TxLogViewModel* model) {
+    model->total_days = tx_log_day_count(BT_TX_LOG_INDEX_PATH);
+    model->day_count = tx_log_read_days(
+        BT_TX_LOG_INDEX_PATH, model->page * TX_LOG_VIEW_LINES, model->days, TX_LOG_VIEW_LINES);
+}
+
+/**
+ * @brief      Callback of the TX log screen on enter, starts from the newest days.
+ * @param      context  The context - App object.
+*/
+void tx_log_view_enter_callback(void* context) {
+    App* app = (App*)context;
+    with_view_model(
+        app->view_tx_log,
+        TxLogViewModel * model,
+        {
+            model->page = 0;
+            tx_log_view_load(model);
+        },
+        true);
+}
+
+/**
+ * @brief      Callback for drawing the TX log screen.
+ * @details    One line per day: date, events and then the button events per button.
+ * @param      canvas  The canvas to draw on.
+ * @param      model   The model - TxLogViewModel object.
+*/
+void tx_log_view_draw_callback(Canvas* canvas, void* model) {
+    TxLogViewModel* log_model = (TxLogViewModel*)model;
+    char line[32];
+    int32_t y = 18;
+
+    canvas_clear(canvas);
+    futils_draw_header(canvas, "TX Log", log_model->page, 8);
+    if(log_model->total_days == 0) {
+        canvas_draw_str(canvas, 0, y, "No events logged yet");
+        return;
+    }
+    canvas_draw_str(canvas, 0, y, "Day   Events  Buttons");
+    y += 10;
+    for(uint8_t i = 0; i < log_model->day_count; i++) {
+        const TxLogDay* day = &log_model->days[i];
+        DateTime datetime;
+        datetime_timestamp_to_datetime(day->day * 60 * 60 * 24, &datetime);
+        snprintf(
+            line,
+            sizeof(line),
+            "%02u-%02u %lu  %u/%u/%u/%u/%u",
+            datetime.month,
+            datetime.day,
+            day->count,
+            day->buttons[0],
+            day->buttons[1],
+            day->buttons[2],
+            day->buttons[3],
+            day->buttons[4]);
+        canvas_draw_str(canvas, 0, y, line);
+        y += 10;
+    }
+}
+
+/**
+ * @brief      Callback for TX log screen input.
+ * @details    Right goes to older days, Left to newer ones, Ok reloads.
+ * @param      event    The event - InputEvent object.
+ * @param      context  The context - App object.
+ * @return     true if the event was handled, false otherwise.
+*/
+bool tx_log_view_input_callback(InputEvent* event, void* context) {
+    App* app = (App*)context;
+    if(event->type != InputTypeShort) {
+        return false;
+    }
+
+    bool consumed = true;
+    with_view_model(
+        app->view_tx_log,
+        TxLogViewModel * model,
+        {
+            switch(event->key) {
+            case InputKeyLeft:
+                if(model->page > 0) {
+                    model->page--;
+                    tx_log_view_load(model);
+                }
+                break;
+            case InputKeyRight:
+                if((model->page + 1) * TX_LOG_VIEW_LINES < model->total_days) {
+                    model->page++;
+                    tx_log_view_load(model);
+                }
+                break;
+            case InputKeyOk:
+                tx_log_view_load(model);
+                break;
+            default:
+                consumed = false;
+                break;
+            }
+        },
+        consumed);
+    return consumed;
+}
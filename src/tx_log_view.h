@@ -0,0 +1,15 @@
+#pragma once
+#include "app.h"
+
+#define TX_LOG_VIEW_LINES 4
+
+typedef struct {
+    TxLogDay days[TX_LOG_VIEW_LINES];
+    uint8_t day_count; // Read for the current page
+    uint32_t total_days;
+    uint8_t page;
+} TxLogViewModel;
+
+void tx_log_view_enter_callback(void* context);
+void tx_log_view_draw_callback(Canvas* canvas, void* model);
+bool tx_log_view_input_callback(InputEvent* event, void* context);
@@ -0,0 +1,171 @@
+#include "uart_bridge.h"
+#include "command.h"
+#include "libs/alloc_tracker.h"
+#include <expansion/expansion.h>
+
+#define UART_BRIDGE_TAG "UART_BRIDGE"
+
+typedef enum {
+    UartBridgeEventStop = 1 << 0,
+    UartBridgeEventRx = 1 << 1,
+} UartBridgeEvent;
+
+struct UartBridge {
+    FuriThread* thread;
+    FuriThreadId thread_id;
+    FuriStreamBuffer* rx_stream; // Filled by the DMA callback, drained by the thread
+    FuriHalSerialHandle* serial;
+    UartBridgeLineCallback callback;
+    void* context;
+    CmdLine line;
+    uint32_t lines;
+    uint32_t errors;
+    volatile uint32_t dropped; // Bytes lost because the stream buffer was full
+};
+
+/**
+ * @brief      DMA RX callback, runs in interrupt context.
+ * @details    Only moves the bytes to the stream buffer and wakes up the thread.
+*/
+static void uart_bridge_rx_callback(
+    FuriHalSerialHandle* handle,
+    FuriHalSerialRxEvent event,
+    size_t data_len,
+    void* context) {
+    UartBridge* bridge = (UartBridge*)context;
+    if(event & (FuriHalSerialRxEventData | FuriHalSerialRxEventIdle)) {
+        uint8_t data[32];
+        while(data_len > 0) {
+            size_t len = furi_hal_serial_dma_rx(handle, data, MIN(data_len, sizeof(data)));
+            if(len == 0) {
+                break;
+            }
+            bridge->dropped += len - furi_stream_buffer_send(bridge->rx_stream, data, len, 0);
+            data_len -= len;
+        }
+        furi_thread_flags_set(bridge->thread_id, UartBridgeEventRx);
+    }
+}
+
+static void uart_bridge_tx_str(UartBridge* bridge, const char* str) {
+    furi_hal_serial_tx(bridge->serial, (const uint8_t*)str, strlen(str));
+}
+
+/**
+ * @brief      Send the reply of a line, without building it in a buffer.
+*/
+static void uart_bridge_reply(UartBridge* bridge, bool ok, const char* error) {
+    if(ok) {
+        uart_bridge_tx_str(bridge, "OK\r\n");
+        return;
+    }
+    bridge->errors++;
+    uart_bridge_tx_str(bridge, "ERR ");
+    uart_bridge_tx_str(bridge, error);
+    uart_bridge_tx_str(bridge, "\r\n");
+}
+
+/**
+ * @brief      Add a received byte to the current line, a line ending dispatches it.
+*/
+static void uart_bridge_feed(UartBridge* bridge, char c) {
+    const char* error = "rejected";
+    switch(cmd_line_feed(&bridge->line, c)) {
+    case CmdLineReady:
+        bridge->lines++;
+        uart_bridge_reply(
+            bridge, bridge->callback(bridge->line.buf, &error, bridge->context), error);
+        break;
+    case CmdLineTooLong:
+        uart_bridge_reply(bridge, false, "line too long");
+        break;
+    default:
+        break;
+    }
+}
+
+static int32_t uart_bridge_worker(void* context) {
+    UartBridge* bridge = (UartBridge*)context;
+    uint8_t chunk[32];
+
+    while(true) {
+        uint32_t events = furi_thread_flags_wait(
+            UartBridgeEventStop | UartBridgeEventRx, FuriFlagWaitAny, FuriWaitForever);
+        if(events & FuriFlagError) {
+            continue;
+        }
+        if(events & UartBridgeEventStop) {
+            break;
+        }
+        size_t len;
+        while((len = furi_stream_buffer_receive(bridge->rx_stream, chunk, sizeof(chunk), 0)) >
+              0) {
+            for(size_t i = 0; i < len; i++) {
+                uart_bridge_feed(bridge, chunk[i]);
+            }
+        }
+    }
+    FURI_LOG_I(
+        UART_BRIDGE_TAG,
+        "%lu lines, %lu errors, %lu bytes dropped",
+        bridge->lines,
+        bridge->errors,
+        bridge->dropped);
+    return 0;
+}
+
+/**
+ * @brief      Take the USART and start the bridge thread.
+ * @param      callback  Called for every received line.
+ * @param      context   The callback context.
+ * @return     the UartBridge object, NULL if the USART is busy
+*/
+UartBridge* uart_bridge_alloc(UartBridgeLineCallback callback, void* context) {
+    // The expansion module service owns the USART while enabled
+    Expansion* expansion = furi_record_open(RECORD_EXPANSION);
+    expansion_disable(expansion);
+    furi_record_close(RECORD_EXPANSION);
+
+    FuriHalSerialHandle* serial = furi_hal_serial_control_acquire(FuriHalSerialIdUsart);
+    if(serial == NULL) {
+        FURI_LOG_E(UART_BRIDGE_TAG, "USART busy");
+        expansion = furi_record_open(RECORD_EXPANSION);
+        expansion_enable(expansion);
+        furi_record_close(RECORD_EXPANSION);
+        return NULL;
+    }
+
+    UartBridge* bridge = ATRACK_MALLOC(sizeof(UartBridge));
+    bridge->serial = serial;
+    bridge->callback = callback;
+    bridge->context = context;
+    bridge->rx_stream = furi_stream_buffer_alloc(UART_BRIDGE_RX_BUF_SIZE, 1);
+    bridge->thread = furi_thread_alloc_ex("UartBridge", 1024, uart_bridge_worker, bridge);
+    furi_thread_start(bridge->thread);
+    bridge->thread_id = furi_thread_get_id(bridge->thread);
+
+    furi_hal_serial_init(bridge->serial, UART_BRIDGE_BAUD);
+    furi_hal_serial_dma_rx_start(bridge->serial, uart_bridge_rx_callback, bridge, false);
+    FURI_LOG_I(UART_BRIDGE_TAG, "Started at %u baud", UART_BRIDGE_BAUD);
+    return bridge;
+}
+
+/**
+ * @brief      Stop the bridge thread and give the USART back.
+ * @param      bridge  The UartBridge object.
+*/
+void uart_bridge_free(UartBridge* bridge) {
+    furi_hal_serial_dma_rx_stop(bridge->serial);
+    furi_hal_serial_deinit(bridge->serial);
+    furi_hal_serial_control_release(bridge->serial);
+
+    furi_thread_flags_set(bridge->thread_id, UartBridgeEventStop);
+    furi_thread_join(bridge->thread);
+    furi_thread_free(bridge->thread);
+    furi_stream_buffer_free(bridge->rx_stream);
+    ATRACK_FREE(bridge);
+
+    Expansion* expansion = furi_record_open(RECORD_EXPANSION);
+    expansion_enable(expansion);
+    furi_record_close(RECORD_EXPANSION);
+}
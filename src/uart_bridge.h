@@ -0,0 +1,23 @@
+#pragma once
+#include <furi.h>
+#include <furi_hal.h>
+
+// Line based command bridge on the GPIO USART (pins 13 TX, 14 RX).
+// Every line gets an "OK" or "ERR <reason>" reply, lines are framed by cmd_line_feed().
+
+#define UART_BRIDGE_BAUD        115200
+#define UART_BRIDGE_RX_BUF_SIZE 256
+
+/**
+ * @brief      Called from the bridge thread for every received line.
+ * @param      line     The null terminated line, without the line ending, may be modified.
+ * @param      error    Set to a short reason when the line is rejected.
+ * @param      context  The callback context.
+ * @return     true if the line was accepted
+*/
+typedef bool (*UartBridgeLineCallback)(char* line, const char** error, void* context);
+
+typedef struct UartBridge UartBridge;
+
+UartBridge* uart_bridge_alloc(UartBridgeLineCallback callback, void* context);
+void uart_bridge_free(UartBridge* bridge);
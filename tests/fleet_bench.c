@@ -0,0 +1,92 @@
+#include "src/fleet_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// The fleet simulation on the host, with every jitter setting of the config page, for fleets
+// larger than the Flipper has time or memory for. With several runs every run has its own seed,
+// the rates add up over the runs and the latency percentiles are averaged.
+// Usage: fleet_bench [devices] [spread ms] [interval ms] [duration ms] [send count] [adaptive]
+//                    [runs]
+
+#define FLEET_BENCH_PDU_US 376 // Button event with the name left out
+#define FLEET_BENCH_SEED   0x2545F491UL
+
+typedef struct {
+    const char* name;
+    uint8_t offset_ms;
+    uint8_t interval_pct;
+} FleetBenchJitter;
+
+// As adv_jitter_names and adv_jitter_values
+static const FleetBenchJitter jitters[] = {
+    {"Off", 0, 0},
+    {"10ms 10%", 10, 10},
+    {"20ms 25%", 20, 25},
+    {"50ms 50%", 50, 50},
+};
+
+static uint32_t fleet_bench_arg(int argc, char** argv, int index, uint32_t value) {
+    return argc > index ? strtoul(argv[index], NULL, 0) : value;
+}
+
+int main(int argc, char** argv) {
+    FleetSimConfig config = {
+        .devices = fleet_bench_arg(argc, argv, 1, 100),
+        .spread_ms = fleet_bench_arg(argc, argv, 2, 1000),
+        .sched =
+            {
+                .period_ms = fleet_bench_arg(argc, argv, 3, 20),
+                .duration_ms = fleet_bench_arg(argc, argv, 4, 1000),
+                .send_count = fleet_bench_arg(argc, argv, 5, 0),
+                .adaptive = fleet_bench_arg(argc, argv, 6, 0),
+            },
+        .channel_map = 0x07,
+        .pdu_us = FLEET_BENCH_PDU_US,
+    };
+    printf(
+        "%u remotes within %u ms, interval %u ms, %s %u, %s schedule, PDU %u us\n",
+        config.devices,
+        config.spread_ms,
+        config.sched.period_ms,
+        config.sched.send_count ? "send count" : "duration ms",
+        config.sched.send_count ? config.sched.send_count : config.sched.duration_ms,
+        config.sched.adaptive ? "adaptive" : "fixed",
+        config.pdu_us);
+    const uint32_t runs = fleet_bench_arg(argc, argv, 7, 1);
+    for(size_t i = 0; i < sizeof(jitters) / sizeof(jitters[0]); i++) {
+        config.sched.offset_ms = jitters[i].offset_ms;
+        config.sched.interval_pct = jitters[i].interval_pct;
+        FleetSimResult total = {0};
+        uint32_t latency[3] = {0};
+        const clock_t start = clock();
+        for(uint32_t run = 0; run < runs; run++) {
+            FleetSimResult result;
+            config.seed = FLEET_BENCH_SEED + run;
+            if(!fleet_sim_run(&config, &result)) {
+                fprintf(stderr, "out of memory\n");
+                return EXIT_FAILURE;
+            }
+            total.presses += result.presses;
+            total.delivered += result.delivered;
+            total.events += result.events;
+            total.collided += result.collided;
+            latency[0] += result.latency_p50;
+            latency[1] += result.latency_p90;
+            latency[2] += result.latency_p99;
+            total.sim_ms = result.sim_ms;
+        }
+        printf(
+            "jitter %-8s: delivered %3u%%, collided %3u%%, latency ms p50 %u p90 %u p99 %u, "
+            "%.1f ms for %u ms\n",
+            jitters[i].name,
+            total.delivered * 100 / total.presses,
+            total.events ? total.collided * 100 / total.events : 0,
+            latency[0] / runs,
+            latency[1] / runs,
+            latency[2] / runs,
+            (double)(clock() - start) * 1000 / CLOCKS_PER_SEC / runs,
+            total.sim_ms);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+
+// Minimal host test helpers, a failed check reports its location and the test exits with 1.
+
+static int test_failures;
+
+#define COUNT_OF(x) (sizeof(x) / sizeof(x[0]))
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if(!(cond)) {                                                                \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            test_failures++;                                                         \
+        }                                                                            \
+    } while(0)
+
+#define CHECK_EQ(a, b)                                                                        \
+    do {                                                                                      \
+        const long long _a = (long long)(a), _b = (long long)(b);                             \
+        if(_a != _b) {                                                                        \
+            fprintf(stderr, "%s:%d: %s is %lld, not %lld\n", __FILE__, __LINE__, #a, _a, _b); \
+            test_failures++;                                                                  \
+        }                                                                                     \
+    } while(0)
+
+#define TEST_RUN(test)                                                        \
+    do {                                                                      \
+        const int _before = test_failures;                                    \
+        test();                                                               \
+        printf("%s %s\n", _before == test_failures ? "PASS" : "FAIL", #test); \
+    } while(0)
+
+#define TEST_EXIT() return test_failures ? EXIT_FAILURE : EXIT_SUCCESS
@@ -0,0 +1,76 @@
+#include "test.h"
+#include "src/adv_inspect.h"
+#include <string.h>
+
+// The decode cache: a new packet id alone is patched in, anything else is decoded again.
+
+#define ID_POS 9
+
+static const uint8_t packet[] = {
+    0x02, 0x01, 0x06, // Flags
+    0x08, 0x16, 0xD2, 0xFC, 0x40, 0x00, 0x05, 0x3A, 0x01, // BTHome: packet id 5, short press
+};
+
+static void test_decode(void) {
+    AdvInspect inspect = {0};
+    CHECK(adv_inspect_update(&inspect, packet, sizeof(packet)));
+    CHECK_EQ(inspect.decodes, 1);
+    CHECK_EQ(inspect.ad_count, 2);
+    CHECK_EQ(inspect.obj_count, 2);
+    CHECK_EQ(inspect.id_pos, ID_POS);
+    CHECK(strcmp(inspect.lines[0], "0201060816D2FC400005") == 0);
+    CHECK(strcmp(inspect.lines[inspect.id_line], " 00 packet id 5") == 0);
+    CHECK(strcmp(inspect.lines[inspect.id_line + 1], " 3A button short") == 0);
+
+    // The same packet again is a hit
+    CHECK(!adv_inspect_update(&inspect, packet, sizeof(packet)));
+    CHECK_EQ(inspect.decodes, 1);
+    CHECK_EQ(inspect.id_updates, 0);
+}
+
+static void test_packet_id(void) {
+    AdvInspect inspect = {0};
+    uint8_t next[sizeof(packet)];
+    adv_inspect_update(&inspect, packet, sizeof(packet));
+    memcpy(next, packet, sizeof(packet));
+    for(uint16_t id = 6; id < 300; id++) {
+        next[ID_POS] = (uint8_t)id;
+        CHECK(!adv_inspect_update(&inspect, next, sizeof(next)));
+    }
+    CHECK_EQ(inspect.decodes, 1);
+    CHECK_EQ(inspect.id_updates, 300 - 6);
+
+    // The patched text reads like a full decode of the last packet
+    AdvInspect fresh = {0};
+    adv_inspect_update(&fresh, next, sizeof(next));
+    CHECK_EQ(inspect.line_count, fresh.line_count);
+    for(uint8_t i = 0; i < fresh.line_count; i++) {
+        CHECK(strcmp(inspect.lines[i], fresh.lines[i]) == 0);
+    }
+    CHECK(strcmp(inspect.lines[inspect.id_line], " 00 packet id 43") == 0);
+}
+
+static void test_payload_change(void) {
+    AdvInspect inspect = {0};
+    uint8_t next[sizeof(packet)];
+    adv_inspect_update(&inspect, packet, sizeof(packet));
+    memcpy(next, packet, sizeof(packet));
+    next[ID_POS]++;
+    next[ID_POS + 2] = 0x02; // Double press
+    CHECK(adv_inspect_update(&inspect, next, sizeof(next)));
+    CHECK_EQ(inspect.decodes, 2);
+    CHECK_EQ(inspect.id_updates, 0);
+    CHECK(strcmp(inspect.lines[inspect.id_line + 1], " 3A button double") == 0);
+
+    // Shorter data is never a hit, even as a prefix
+    CHECK(adv_inspect_update(&inspect, packet, 3));
+    CHECK_EQ(inspect.decodes, 3);
+    CHECK_EQ(inspect.id_pos, 0);
+}
+
+int main(void) {
+    TEST_RUN(test_decode);
+    TEST_RUN(test_packet_id);
+    TEST_RUN(test_payload_change);
+    TEST_EXIT();
+}
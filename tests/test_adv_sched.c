@@ -0,0 +1,195 @@
+#include "test.h"
+#include "src/adv_sched.h"
+#include <stdbool.h>
+
+// The advertising schedule of the comm worker against a HAL that records the calls: the step
+// math, the window, the jitter drawn again for every step and the start offset.
+
+typedef struct {
+    bool draw_max; // random_below() returns bound - 1, otherwise 0
+    uint32_t draws;
+    uint32_t intervals; // set_interval() calls
+    uint32_t min_ms;
+    uint32_t max_ms;
+    uint32_t starts;
+    uint32_t delay_ms;
+    uint32_t timer_ms;
+} TestHal;
+
+static uint32_t test_random_below(uint32_t bound, void* context) {
+    TestHal* test = context;
+    test->draws++;
+    return test->draw_max ? bound - 1 : 0;
+}
+
+static void test_set_interval(uint32_t min_ms, uint32_t max_ms, void* context) {
+    TestHal* test = context;
+    test->intervals++;
+    test->min_ms = min_ms;
+    test->max_ms = max_ms;
+}
+
+static void test_start(uint32_t delay_ms, void* context) {
+    TestHal* test = context;
+    test->starts++;
+    test->delay_ms = delay_ms;
+}
+
+static void test_timer(uint32_t ms, void* context) {
+    TestHal* test = context;
+    test->timer_ms = ms;
+}
+
+static AdvSchedHal test_hal(TestHal* test) {
+    return (AdvSchedHal){
+        .random_below = test_random_below,
+        .set_interval = test_set_interval,
+        .start = test_start,
+        .timer = test_timer,
+        .context = test,
+    };
+}
+
+static void test_interval(void) {
+    const AdvSchedConfig config = {.period_ms = 20, .duration_ms = 1000, .adaptive = true};
+    static const uint16_t expected[] = {20, 40, 80, 160, 320, 640, 640, 640};
+    for(uint8_t step = 0; step < COUNT_OF(expected); step++) {
+        CHECK_EQ(adv_sched_interval(&config, step), expected[step]);
+    }
+    CHECK(adv_sched_is_adaptive(&config));
+    const AdvSchedConfig count = {.period_ms = 20, .send_count = 3, .adaptive = true};
+    CHECK(!adv_sched_is_adaptive(&count));
+}
+
+static void test_adaptive(void) {
+    const AdvSchedConfig config = {.period_ms = 20, .duration_ms = 1000, .adaptive = true};
+    TestHal test = {0};
+    const AdvSchedHal hal = test_hal(&test);
+    AdvSched sched = {0};
+
+    adv_sched_begin(&sched, &config, &hal, true);
+    CHECK_EQ(test.intervals, 1);
+    CHECK_EQ(test.min_ms, 20);
+    CHECK_EQ(test.max_ms, 30);
+    CHECK_EQ(sched.window_ms, 1000);
+    CHECK_EQ(sched.elapsed_ms, 200);
+    // 10 events at 20 ms, 10 at 40 ms, then 5 at 80 ms in what is left of the window
+    CHECK_EQ(adv_sched_adv_events(&config, &sched), 25);
+    CHECK_EQ(sched.airtime_saved_pct, 50);
+
+    adv_sched_start(&sched, &config, &hal, true);
+    CHECK_EQ(test.starts, 1);
+    CHECK_EQ(test.delay_ms, 0);
+    CHECK_EQ(test.timer_ms, 200);
+
+    static const uint32_t step_ms[] = {400, 400};
+    static const uint32_t min_ms[] = {40, 80};
+    for(uint8_t i = 0; i < COUNT_OF(step_ms); i++) {
+        CHECK(adv_sched_next(&sched, &config, &hal));
+        CHECK_EQ(sched.step, i + 1);
+        CHECK_EQ(test.timer_ms, step_ms[i]);
+        CHECK_EQ(test.min_ms, min_ms[i]);
+        CHECK_EQ(test.max_ms, min_ms[i] * 3 / 2);
+    }
+    CHECK_EQ(sched.elapsed_ms, 1000);
+    CHECK(!adv_sched_next(&sched, &config, &hal));
+    CHECK_EQ(sched.step, 0);
+    CHECK_EQ(test.intervals, 3);
+}
+
+static void test_fixed(void) {
+    const AdvSchedConfig config = {.period_ms = 20, .duration_ms = 1000};
+    TestHal test = {0};
+    const AdvSchedHal hal = test_hal(&test);
+    AdvSched sched = {0};
+    adv_sched_begin(&sched, &config, &hal, true);
+    CHECK_EQ(sched.elapsed_ms, 1000);
+    CHECK_EQ(adv_sched_adv_events(&config, &sched), 50);
+    CHECK_EQ(sched.airtime_saved_pct, 0);
+    CHECK(!adv_sched_next(&sched, &config, &hal));
+    CHECK_EQ(test.intervals, 1);
+}
+
+static void test_send_count(void) {
+    // The window fits the events at the slowest interval the controller may pick
+    const AdvSchedConfig config = {.period_ms = 20, .duration_ms = 1000, .send_count = 5};
+    TestHal test = {0};
+    const AdvSchedHal hal = test_hal(&test);
+    AdvSched sched = {0};
+    adv_sched_begin(&sched, &config, &hal, true);
+    CHECK_EQ(sched.window_ms, 5 * (30 + ADV_DELAY_MAX));
+    CHECK_EQ(adv_sched_window_ms(&config, 30), sched.window_ms);
+    CHECK_EQ(adv_sched_max_window_ms(&config), sched.window_ms);
+    CHECK_EQ(adv_sched_adv_events(&config, &sched), 5);
+    CHECK_EQ(sched.airtime_saved_pct, 90);
+}
+
+static void test_jitter(void) {
+    const AdvSchedConfig config = {
+        .period_ms = 20,
+        .duration_ms = 1000,
+        .adaptive = true,
+        .offset_ms = 20,
+        .interval_pct = 50,
+    };
+    TestHal test = {.draw_max = true};
+    const AdvSchedHal hal = test_hal(&test);
+    AdvSched sched = {0};
+
+    adv_sched_begin(&sched, &config, &hal, true);
+    CHECK_EQ(test.min_ms, 30);
+    CHECK_EQ(test.max_ms, 45);
+    adv_sched_start(&sched, &config, &hal, true);
+    CHECK_EQ(test.draws, 2);
+    CHECK_EQ(sched.offset_ms, 20);
+    CHECK_EQ(test.delay_ms, 20);
+    // The first step is timed from the start
+    CHECK_EQ(test.timer_ms, 20 + sched.elapsed_ms);
+
+    // Every step draws its own increase
+    CHECK(adv_sched_next(&sched, &config, &hal));
+    CHECK_EQ(test.draws, 3);
+    CHECK_EQ(test.min_ms, 60);
+    CHECK_EQ(test.max_ms, 90);
+
+    // The largest window the jitter can draw
+    const AdvSchedConfig count = {.period_ms = 20, .send_count = 4, .interval_pct = 50};
+    CHECK_EQ(adv_sched_max_window_ms(&count), 4 * (45 + ADV_DELAY_MAX));
+}
+
+static void test_data_update(void) {
+    // A beacon already on air keeps its interval and isn't started again
+    const AdvSchedConfig config = {.period_ms = 20, .duration_ms = 1000, .offset_ms = 10};
+    TestHal test = {0};
+    const AdvSchedHal hal = test_hal(&test);
+    AdvSched sched = {.min_interval_ms = 20, .max_interval_ms = 30};
+    adv_sched_begin(&sched, &config, &hal, false);
+    adv_sched_start(&sched, &config, &hal, false);
+    CHECK_EQ(test.intervals, 0);
+    CHECK_EQ(test.starts, 0);
+    CHECK_EQ(test.draws, 0);
+    CHECK_EQ(test.timer_ms, 1000);
+}
+
+static void test_interval_limit(void) {
+    // The range stays within the HAL limit, whatever the period and the jitter
+    const AdvSchedConfig config = {.period_ms = 10000, .duration_ms = 20000, .interval_pct = 50};
+    TestHal test = {.draw_max = true};
+    const AdvSchedHal hal = test_hal(&test);
+    AdvSched sched = {0};
+    adv_sched_begin(&sched, &config, &hal, true);
+    CHECK(test.max_ms <= ADV_INTERVAL_MAX);
+    CHECK_EQ(test.min_ms, ADV_INTERVAL_MAX * 2 / 3);
+    CHECK_EQ(sched.max_interval_ms, test.max_ms);
+}
+
+int main(void) {
+    TEST_RUN(test_interval);
+    TEST_RUN(test_adaptive);
+    TEST_RUN(test_fixed);
+    TEST_RUN(test_send_count);
+    TEST_RUN(test_jitter);
+    TEST_RUN(test_data_update);
+    TEST_RUN(test_interval_limit);
+    TEST_EXIT();
+}
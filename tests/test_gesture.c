@@ -0,0 +1,251 @@
+#include "test.h"
+#include "src/bthome.h"
+#include "src/gesture.h"
+
+// Synthetic input traces fed to the recognizer, every reported event is checked with its time.
+
+#define TRACE_MAX_EVENTS 8
+
+typedef enum {
+    StepPress,
+    StepRelease,
+    StepTick,
+} StepType;
+
+typedef struct {
+    StepType type;
+    uint8_t key;
+    uint32_t now;
+} Step;
+
+typedef struct {
+    uint8_t key;
+    uint8_t event;
+    uint32_t now;
+} Reported;
+
+typedef struct {
+    uint32_t now;
+    uint8_t count;
+    Reported events[TRACE_MAX_EVENTS];
+} Recorder;
+
+static const GestureConfig config = {
+    .multi_window_ms = 300,
+    .long_ms = 500,
+    .max_presses = 3,
+};
+
+static void record(uint8_t key, uint8_t event, void* context) {
+    Recorder* recorder = context;
+    if(recorder->count < TRACE_MAX_EVENTS) {
+        recorder->events[recorder->count++] = (Reported){key, event, recorder->now};
+    }
+}
+
+static void run_trace(
+    const GestureConfig* cfg,
+    const Step* steps,
+    size_t step_count,
+    const Reported* expected,
+    uint8_t expected_count) {
+    Gesture gesture;
+    Recorder recorder = {0};
+    gesture_init(&gesture, cfg, record, &recorder);
+    for(size_t i = 0; i < step_count; i++) {
+        recorder.now = steps[i].now;
+        switch(steps[i].type) {
+        case StepPress:
+            gesture_press(&gesture, steps[i].key, steps[i].now);
+            break;
+        case StepRelease:
+            gesture_release(&gesture, steps[i].key, steps[i].now);
+            break;
+        case StepTick:
+            gesture_tick(&gesture, steps[i].now);
+            break;
+        }
+    }
+    CHECK_EQ(recorder.count, expected_count);
+    for(uint8_t i = 0; i < recorder.count && i < expected_count; i++) {
+        CHECK_EQ(recorder.events[i].key, expected[i].key);
+        CHECK_EQ(recorder.events[i].event, expected[i].event);
+        CHECK_EQ(recorder.events[i].now, expected[i].now);
+    }
+}
+
+#define RUN_TRACE(cfg, steps, expected) \
+    run_trace(cfg, steps, COUNT_OF(steps), expected, COUNT_OF(expected))
+
+static void test_short(void) {
+    // Reported once the multi press window after the release is over, not before
+    const Step steps[] = {
+        {StepPress, 0, 1000},
+        {StepRelease, 0, 1080},
+        {StepTick, 0, 1379},
+        {StepTick, 0, 1380},
+        {StepTick, 0, 1500},
+    };
+    const Reported expected[] = {{0, BTHomeShortPress, 1380}};
+    RUN_TRACE(&config, steps, expected);
+}
+
+static void test_double(void) {
+    const Step steps[] = {
+        {StepPress, 1, 0},
+        {StepRelease, 1, 90},
+        {StepTick, 1, 200},
+        {StepPress, 1, 250},
+        {StepRelease, 1, 330},
+        {StepTick, 1, 629},
+        {StepTick, 1, 630},
+    };
+    const Reported expected[] = {{1, BTHomeDoublePress, 630}};
+    RUN_TRACE(&config, steps, expected);
+}
+
+static void test_late_press(void) {
+    // A press after the window, before the tick reports it, is a new gesture, not a double
+    const Step steps[] = {
+        {StepPress, 0, 0},
+        {StepRelease, 0, 80},
+        {StepPress, 0, 400},
+        {StepRelease, 0, 480},
+        {StepTick, 0, 779},
+        {StepTick, 0, 780},
+    };
+    const Reported expected[] = {
+        {0, BTHomeShortPress, 400},
+        {0, BTHomeShortPress, 780},
+    };
+    RUN_TRACE(&config, steps, expected);
+}
+
+static void test_triple(void) {
+    // The max press count is reached, no need to wait for the window
+    const Step steps[] = {
+        {StepPress, 2, 0},
+        {StepRelease, 2, 60},
+        {StepPress, 2, 200},
+        {StepRelease, 2, 260},
+        {StepPress, 2, 400},
+        {StepRelease, 2, 460},
+        {StepTick, 2, 2000},
+    };
+    const Reported expected[] = {{2, BTHomeTriplePress, 460}};
+    RUN_TRACE(&config, steps, expected);
+}
+
+static void test_long(void) {
+    // No tick while the key is held, the long press is reported at the release
+    const Step steps[] = {
+        {StepPress, 0, 0},
+        {StepRelease, 0, 650},
+        {StepTick, 0, 2000},
+    };
+    const Reported expected[] = {{0, BTHomeLongPress, 650}};
+    RUN_TRACE(&config, steps, expected);
+}
+
+static void test_hold(void) {
+    // Reported while the key is still held, the release and the next ticks add nothing
+    const Step steps[] = {
+        {StepPress, 3, 0},
+        {StepTick, 3, 499},
+        {StepTick, 3, 500},
+        {StepTick, 3, 1500},
+        {StepRelease, 3, 3000},
+        {StepTick, 3, 4000},
+        {StepPress, 3, 5000},
+        {StepRelease, 3, 5100},
+        {StepTick, 3, 5400},
+    };
+    const Reported expected[] = {
+        {3, BTHomeLongPress, 500},
+        {3, BTHomeShortPress, 5400},
+    };
+    RUN_TRACE(&config, steps, expected);
+}
+
+static void test_long_double(void) {
+    const Step steps[] = {
+        {StepPress, 4, 0},
+        {StepRelease, 4, 100},
+        {StepPress, 4, 300},
+        {StepTick, 4, 800},
+        {StepRelease, 4, 1200},
+    };
+    const Reported expected[] = {{4, BTHomeLongDoublePress, 800}};
+    RUN_TRACE(&config, steps, expected);
+}
+
+static void test_keys_independent(void) {
+    const Step steps[] = {
+        {StepPress, 0, 0},
+        {StepPress, 1, 20},
+        {StepRelease, 0, 100},
+        {StepRelease, 1, 120},
+        {StepPress, 1, 200},
+        {StepRelease, 1, 260},
+        {StepTick, 0, 400},
+        {StepTick, 0, 560},
+    };
+    const Reported expected[] = {
+        {0, BTHomeShortPress, 400},
+        {1, BTHomeDoublePress, 560},
+    };
+    RUN_TRACE(&config, steps, expected);
+}
+
+static void test_multi_disabled(void) {
+    // max_presses 1: a short press is final at its release
+    const GestureConfig single = {.multi_window_ms = 300, .long_ms = 500, .max_presses = 1};
+    const Step steps[] = {
+        {StepPress, 0, 0},
+        {StepRelease, 0, 50},
+        {StepPress, 0, 100},
+        {StepRelease, 0, 150},
+    };
+    const Reported expected[] = {
+        {0, BTHomeShortPress, 50},
+        {0, BTHomeShortPress, 150},
+    };
+    RUN_TRACE(&single, steps, expected);
+}
+
+static void test_deadline(void) {
+    Gesture gesture;
+    Recorder recorder = {0};
+    uint32_t deadline = 0;
+    gesture_init(&gesture, &config, record, &recorder);
+    CHECK(!gesture_next_deadline(&gesture, &deadline));
+
+    gesture_press(&gesture, 0, 1000);
+    CHECK(gesture_next_deadline(&gesture, &deadline));
+    CHECK_EQ(deadline, 1500);
+    gesture_release(&gesture, 0, 1100);
+    gesture_press(&gesture, 1, 1200);
+    CHECK(gesture_next_deadline(&gesture, &deadline));
+    CHECK_EQ(deadline, 1400);
+
+    // The earliest one wins across the tick counter wrap too
+    gesture_reset(&gesture);
+    gesture_press(&gesture, 2, UINT32_MAX - 100);
+    gesture_press(&gesture, 3, UINT32_MAX - 50);
+    CHECK(gesture_next_deadline(&gesture, &deadline));
+    CHECK_EQ(deadline, (uint32_t)(UINT32_MAX - 100 + 500));
+}
+
+int main(void) {
+    TEST_RUN(test_short);
+    TEST_RUN(test_double);
+    TEST_RUN(test_late_press);
+    TEST_RUN(test_triple);
+    TEST_RUN(test_long);
+    TEST_RUN(test_hold);
+    TEST_RUN(test_long_double);
+    TEST_RUN(test_keys_independent);
+    TEST_RUN(test_multi_disabled);
+    TEST_RUN(test_deadline);
+    TEST_EXIT();
+}
@@ -0,0 +1,170 @@
+#include "test.h"
+#include "libs/json_pretty.h"
+#include <string.h>
+#include <time.h>
+
+// The pretty printer against golden outputs, the counting pass against the writing pass, and a
+// timing of a large generated document.
+
+#define OUTPUT_MAX   4096
+#define MAX_TOKENS   1024
+#define BENCH_ITEMS  5000
+#define BENCH_ITEM   "{\"name\":\"a, {b}: [c]\",\"value\":-12.5,\"list\":[1,2,3]},"
+#define BENCH_TOKENS 10 // Per item
+
+typedef struct {
+    char* data;
+    size_t len;
+    size_t size;
+} Output;
+
+static void output_write(const char* data, size_t len, void* context) {
+    Output* output = context;
+    if(output->len + len < output->size) {
+        memcpy(output->data + output->len, data, len);
+        output->data[output->len + len] = '\0';
+    }
+    output->len += len;
+}
+
+/**
+ * @brief      Parse and print, both passes must agree on the size.
+ * @return     the output, valid until the next call
+*/
+static const char* pretty(const char* json, uint8_t width) {
+    static jsmntok_t tokens[MAX_TOKENS];
+    static char text[OUTPUT_MAX];
+    jsmn_parser parser;
+    jsmn_init(&parser);
+    const int count = jsmn_parse(&parser, json, strlen(json), tokens, MAX_TOKENS);
+    CHECK(count > 0);
+    Output output = {.data = text, .size = sizeof(text)};
+    text[0] = '\0';
+    const size_t size = json_pretty_print(json, tokens, count, width, NULL, NULL);
+    CHECK_EQ(json_pretty_print(json, tokens, count, width, output_write, &output), size);
+    CHECK_EQ(output.len, size);
+    CHECK_EQ(strlen(text), size);
+    return text;
+}
+
+static void test_golden(void) {
+    // Separators inside strings are not structure
+    const char* json = "{\"name\":\"a, {b}: [c]\",\"list\":[1,2,{\"x\":\"]\"}],\"empty\":{}}";
+    const char* expected = "{\n"
+                           "  \"name\": \"a, {b}: [c]\",\n"
+                           "  \"list\": [\n"
+                           "    1,\n"
+                           "    2,\n"
+                           "    {\n"
+                           "      \"x\": \"]\"\n"
+                           "    }\n"
+                           "  ],\n"
+                           "  \"empty\": {}\n"
+                           "}";
+    CHECK(strcmp(pretty(json, 0), expected) == 0);
+
+    // Escaped quotes stay in the string
+    CHECK(strcmp(pretty("[\"a\\\",b\"]", 0), "[\n  \"a\\\",b\"\n]") == 0);
+}
+
+static void test_wrap(void) {
+    // Wrapped at the width, the continuation one level deeper
+    const char* expected = "{\n"
+                           "  \"key\": \"012345\n"
+                           "    6789abcdef\"\n"
+                           "}";
+    CHECK(strcmp(pretty("{\"key\":\"0123456789abcdef\"}", 16), expected) == 0);
+}
+
+static void test_sizes(void) {
+    static const char* docs[] = {
+        "{}",
+        "[]",
+        "[1,[2,[3,[4]]],{\"a\":{\"b\":[]}}]",
+        "{\"k\":\"a very long string value, with commas, {braces} and [brackets]\"}",
+        "{\"a\":1}\n{\"b\":2}",
+    };
+    static const uint8_t widths[] = {0, 8, 20, 31};
+    for(size_t d = 0; d < COUNT_OF(docs); d++) {
+        for(size_t w = 0; w < COUNT_OF(widths); w++) {
+            pretty(docs[d], widths[w]);
+        }
+    }
+}
+
+static void test_depth(void) {
+    // Past the max depth the source text is kept, the walk doesn't go deeper
+    char json[2 * 100 + 2];
+    const size_t depth = 100;
+    memset(json, '[', depth);
+    json[depth] = '1';
+    memset(json + depth + 1, ']', depth);
+    json[2 * depth + 1] = '\0';
+    const char* text = pretty(json, 0);
+    char raw[sizeof(json)];
+    const size_t raw_len = 2 * (depth - JSON_PRETTY_MAX_DEPTH) + 1;
+    memcpy(raw, json + JSON_PRETTY_MAX_DEPTH, raw_len);
+    raw[raw_len] = '\0';
+    CHECK(strstr(text, raw) != NULL);
+    CHECK(strstr(text, "[[") == strstr(text, raw));
+    CHECK_EQ(text[strlen(text) - 1], ']');
+
+    // Tokens after a deep subtree are still printed
+    const char* after = "{\"deep\":[[[[[[[[[[[[[[[[[[[[0]]]]]]]]]]]]]]]]]]]],\"next\":true}";
+    CHECK(strstr(pretty(after, 0), "\"next\": true") != NULL);
+}
+
+static void test_bench(void) {
+    const size_t item_len = strlen(BENCH_ITEM);
+    char* json = malloc(item_len * BENCH_ITEMS + 3);
+    jsmntok_t* tokens = malloc(sizeof(jsmntok_t) * (BENCH_ITEMS * BENCH_TOKENS + 1));
+    CHECK(json != NULL && tokens != NULL);
+    if(json == NULL || tokens == NULL) {
+        free(json);
+        free(tokens);
+        return;
+    }
+    size_t len = 0;
+    json[len++] = '[';
+    for(size_t i = 0; i < BENCH_ITEMS; i++) {
+        memcpy(json + len, BENCH_ITEM, item_len);
+        len += item_len;
+    }
+    json[len - 1] = ']';
+    json[len] = '\0';
+
+    const clock_t start = clock();
+    jsmn_parser parser;
+    jsmn_init(&parser);
+    const int count = jsmn_parse(&parser, json, len, tokens, BENCH_ITEMS * BENCH_TOKENS + 1);
+    CHECK_EQ(count, BENCH_ITEMS * BENCH_TOKENS + 1);
+    const clock_t parsed = clock();
+    const size_t size = json_pretty_print(json, tokens, count, 31, NULL, NULL);
+    const clock_t counted = clock();
+    char* text = malloc(size + 1);
+    Output output = {.data = text, .size = size + 1};
+    CHECK_EQ(json_pretty_print(json, tokens, count, 31, output_write, &output), size);
+    const clock_t written = clock();
+    CHECK_EQ(output.len, size);
+
+    const double ms = 1000.0 / CLOCKS_PER_SEC;
+    printf(
+        "  %zu KB: parse %.1f ms, count %.1f ms, write %.1f ms, %zu KB out\n",
+        len / 1024,
+        (parsed - start) * ms,
+        (counted - parsed) * ms,
+        (written - counted) * ms,
+        size / 1024);
+    free(text);
+    free(tokens);
+    free(json);
+}
+
+int main(void) {
+    TEST_RUN(test_golden);
+    TEST_RUN(test_wrap);
+    TEST_RUN(test_sizes);
+    TEST_RUN(test_depth);
+    TEST_RUN(test_bench);
+    TEST_EXIT();
+}
@@ -0,0 +1,136 @@
+#include "test.h"
+#include "src/bthome.h"
+#include "src/macro.h"
+#include <string.h>
+
+// Macro playback on a virtual clock, the way bt_comm_worker() drives it: sleep until the next
+// step is due, wake up some ticks late, send what is due.
+
+#define MAX_SENDS 64
+
+typedef struct {
+    uint32_t tick;
+    uint8_t button;
+} Send;
+
+static uint32_t rng_state = 12345;
+
+static uint32_t rng_below(uint32_t bound) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state % bound;
+}
+
+static void macro_setup(Macro* macro) {
+    // lights off, dehumidifier on 2 s later, then 3 quick toggles
+    static const struct {
+        uint8_t button;
+        uint32_t delay;
+        uint16_t repeat;
+    } lines[] = {{0, 0, 1}, {1, 2000, 1}, {2, 250, 3}};
+    memset(macro, 0, sizeof(Macro));
+    for(uint8_t i = 0; i < COUNT_OF(lines); i++) {
+        macro->steps[i].button = lines[i].button;
+        macro->steps[i].event = BTHomeShortPress;
+        macro->steps[i].delay_ticks = lines[i].delay;
+        macro->steps[i].repeat = lines[i].repeat;
+    }
+    macro->step_count = COUNT_OF(lines);
+    macro->loaded = true;
+}
+
+/**
+ * @brief      Play the macro, every wake up is late by up to max_late ticks.
+ * @return     the number of sends
+*/
+static uint8_t macro_play(Macro* macro, uint32_t start, uint32_t max_late, Send* sends) {
+    uint8_t count = 0;
+    uint32_t now = start;
+    uint32_t due;
+    macro_start(macro, now);
+    while(macro_get_due(macro, &due) && count < MAX_SENDS) {
+        // A wake up before the due tick must not send anything
+        CHECK(macro_next(macro, due - 1) == NULL);
+        now = due + (max_late ? rng_below(max_late + 1) : 0);
+        MacroStep* step = macro_next(macro, now);
+        CHECK(step != NULL);
+        if(step) {
+            sends[count++] = (Send){now, step->button};
+        }
+    }
+    return count;
+}
+
+static const uint32_t ideal[] = {0, 2000, 2250, 2500, 2750};
+static const uint8_t buttons[] = {0, 1, 2, 2, 2};
+
+static void test_exact_timing(void) {
+    Macro macro;
+    Send sends[MAX_SENDS];
+    macro_setup(&macro);
+    const uint8_t count = macro_play(&macro, 1000, 0, sends);
+    CHECK_EQ(count, COUNT_OF(ideal));
+    for(uint8_t i = 0; i < count && i < COUNT_OF(ideal); i++) {
+        CHECK_EQ(sends[i].tick, 1000 + ideal[i]);
+        CHECK_EQ(sends[i].button, buttons[i]);
+    }
+    CHECK_EQ(macro.max_late_ticks, 0);
+    CHECK(!macro.running);
+}
+
+static void test_jitter_no_drift(void) {
+    // Late wake ups only delay their own step, the schedule stays absolute from the start
+    Macro macro;
+    Send sends[MAX_SENDS];
+    macro_setup(&macro);
+    uint32_t max_seen = 0;
+    for(int run = 0; run < 200; run++) {
+        const uint8_t count = macro_play(&macro, 5000, 7, sends);
+        CHECK_EQ(count, COUNT_OF(ideal));
+        uint32_t run_max = 0;
+        for(uint8_t i = 0; i < count && i < COUNT_OF(ideal); i++) {
+            const uint32_t late = sends[i].tick - (5000 + ideal[i]);
+            CHECK(late <= 7);
+            run_max = late > run_max ? late : run_max;
+        }
+        CHECK_EQ(macro.max_late_ticks, run_max);
+        max_seen = run_max > max_seen ? run_max : max_seen;
+    }
+    CHECK_EQ(max_seen, 7);
+}
+
+static void test_tick_wrap(void) {
+    Macro macro;
+    Send sends[MAX_SENDS];
+    macro_setup(&macro);
+    const uint32_t start = UINT32_MAX - 2100;
+    const uint8_t count = macro_play(&macro, start, 3, sends);
+    CHECK_EQ(count, COUNT_OF(ideal));
+    for(uint8_t i = 0; i < count && i < COUNT_OF(ideal); i++) {
+        CHECK((uint32_t)(sends[i].tick - (start + ideal[i])) <= 3);
+    }
+}
+
+static void test_stop_and_not_loaded(void) {
+    Macro macro;
+    uint32_t due;
+    macro_setup(&macro);
+    macro_start(&macro, 0);
+    CHECK(macro_next(&macro, 0) != NULL);
+    macro_stop(&macro);
+    CHECK(!macro_get_due(&macro, &due));
+    CHECK(macro_next(&macro, 10000) == NULL);
+
+    macro.loaded = false;
+    macro_start(&macro, 0);
+    CHECK(!macro.running);
+}
+
+int main(void) {
+    TEST_RUN(test_exact_timing);
+    TEST_RUN(test_jitter_no_drift);
+    TEST_RUN(test_tick_wrap);
+    TEST_RUN(test_stop_and_not_loaded);
+    TEST_EXIT();
+}
@@ -0,0 +1,124 @@
+#include "test.h"
+#include "libs/random_below.h"
+#include <math.h>
+#include <stdbool.h>
+
+// Bucket counts of random_below() against a uniform distribution, with a chi-square test. A
+// seeded splitmix64 stands in for the hardware RNG, so the runs are repeatable.
+
+#define DRAWS_PER_BUCKET 20000
+
+typedef struct {
+    uint64_t state;
+    uint32_t words; // Words drawn so far
+} TestRng;
+
+static uint32_t splitmix_word(void* context) {
+    TestRng* rng = context;
+    uint64_t z = (rng->state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    rng->words++;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+static uint32_t modulo_below(uint32_t bound, TestRng* rng) {
+    return splitmix_word(rng) % bound;
+}
+
+/**
+ * @brief      Chi-square statistic of the bucket counts against equal expected counts.
+*/
+static double chi_square(const uint32_t* counts, uint32_t buckets, uint32_t draws) {
+    const double expected = (double)draws / buckets;
+    double chi2 = 0;
+    for(uint32_t i = 0; i < buckets; i++) {
+        const double delta = counts[i] - expected;
+        chi2 += delta * delta / expected;
+    }
+    return chi2;
+}
+
+/**
+ * @brief      Upper limit of the statistic, about p = 1e-6 for these degrees of freedom.
+*/
+static double chi_square_limit(uint32_t buckets) {
+    const double df = buckets - 1;
+    return df + 7 * sqrt(2 * df) + 10;
+}
+
+/**
+ * @brief      Draw below the bound and count the results in equal ranges of the bound.
+ * @param      biased  use the plain modulo instead of random_below()
+ * @return     the chi-square statistic
+*/
+static double bucket_test(uint32_t bound, uint32_t buckets, bool biased) {
+    uint32_t counts[16] = {0};
+    TestRng rng = {.state = bound};
+    const uint32_t draws = buckets * DRAWS_PER_BUCKET;
+    for(uint32_t i = 0; i < draws; i++) {
+        const uint32_t value = biased ? modulo_below(bound, &rng) :
+                                        random_below(bound, splitmix_word, &rng);
+        CHECK(value < bound);
+        counts[(uint64_t)value * buckets / bound]++;
+    }
+    return chi_square(counts, buckets, draws);
+}
+
+static void test_small_bounds(void) {
+    // Every result is its own bucket
+    static const uint32_t bounds[] = {1, 2, 3, 5, 6, 7, 10, 12, 13, 16};
+    for(size_t i = 0; i < COUNT_OF(bounds); i++) {
+        const uint32_t bound = bounds[i];
+        const double chi2 = bucket_test(bound, bound, false);
+        if(!(chi2 < chi_square_limit(bound))) {
+            fprintf(stderr, "  bound %u: chi2 %.1f\n", bound, chi2);
+        }
+        CHECK(chi2 < chi_square_limit(bound));
+    }
+}
+
+static void test_large_bounds(void) {
+    // The plain modulo favors the low third of 3 << 30 twice as much, the reduction must not
+    static const uint32_t bounds[] = {3UL << 30, 0xAAAAAAABUL, 1000000007UL, 0xFFFFFFFFUL};
+    for(size_t i = 0; i < COUNT_OF(bounds); i++) {
+        CHECK(bucket_test(bounds[i], 12, false) < chi_square_limit(12));
+    }
+    CHECK(bucket_test(3UL << 30, 12, true) > chi_square_limit(12));
+}
+
+typedef struct {
+    const uint32_t* words;
+    uint32_t next;
+} WordList;
+
+static uint32_t list_word(void* context) {
+    WordList* list = context;
+    return list->words[list->next++];
+}
+
+static void test_rejection(void) {
+    // For 3 the threshold is 2^32 % 3 = 1, only the word 0 is drawn again
+    static const uint32_t words[] = {0, 0x80000000UL, 0, 0xFFFFFFFFUL};
+    WordList list = {.words = words};
+    CHECK_EQ(random_below(3, list_word, &list), 1);
+    CHECK_EQ(list.next, 2);
+    // The bound 0 is the whole range, the word as it is
+    CHECK_EQ(random_below(0, list_word, &list), 0);
+    CHECK_EQ(random_below(7, list_word, &list), 6);
+    CHECK_EQ(list.next, 4);
+
+    // Powers of two never draw again
+    TestRng rng = {.state = 1};
+    for(uint32_t i = 0; i < 1000; i++) {
+        random_below(1U << (i % 32), splitmix_word, &rng);
+    }
+    CHECK_EQ(rng.words, 1000);
+}
+
+int main(void) {
+    TEST_RUN(test_small_bounds);
+    TEST_RUN(test_large_bounds);
+    TEST_RUN(test_rejection);
+    TEST_EXIT();
+}
@@ -0,0 +1,75 @@
+#include "test.h"
+#include "src/subghz_codec.h"
+
+// Golden timings of the OOK encoders, in us with the carrier on for positive durations.
+
+static void check_wave(const SubghzKey* key, const int32_t* golden, uint8_t count, uint32_t us) {
+    SubghzWave wave;
+    CHECK(subghz_codec_encode(key, &wave));
+    CHECK_EQ(wave.count, count);
+    for(uint8_t i = 0; i < wave.count && i < count; i++) {
+        CHECK_EQ(wave.timings[i], golden[i]);
+    }
+    CHECK_EQ(subghz_codec_wave_us(&wave), us);
+}
+
+static void test_princeton(void) {
+    // 1010: 3:1 for a 1, 1:3 for a 0, then the 1:30 sync
+    const SubghzKey key = {.proto = SubghzProtoPrinceton, .bits = 4, .key = 0xA};
+    const int32_t golden[] = {1170, -390, 390, -1170, 1170, -390, 390, -1170, 390, -11700};
+    check_wave(&key, golden, COUNT_OF(golden), 4 * 1560 + 390 + 11700);
+}
+
+static void test_came(void) {
+    // 0110: the 36 te low header and the start pulse, then short:long for a 0
+    const SubghzKey key = {.proto = SubghzProtoCame, .bits = 4, .key = 0x6};
+    const int32_t golden[] = {-11520, 320, -320, 640, -640, 320, -640, 320, -320, 640};
+    check_wave(&key, golden, COUNT_OF(golden), 11520 + 320 + 4 * 960);
+}
+
+static void test_frame_length(void) {
+    // A usual 24 bit Princeton remote, 10 frames per event are about half a second on air
+    SubghzKey key = {.proto = SubghzProtoPrinceton, .bits = 24, .key = 0x123456};
+    SubghzWave wave;
+    CHECK(subghz_codec_encode(&key, &wave));
+    CHECK_EQ(wave.count, 24 * 2 + 2);
+    CHECK_EQ(subghz_codec_wave_us(&wave), 24 * 1560 + 390 + 11700);
+
+    // The longest code fills the wave exactly, the MSB goes first
+    key = (SubghzKey){.proto = SubghzProtoCame, .bits = SUBGHZ_CODE_MAX_BITS, .key = 1UL << 31};
+    CHECK(subghz_codec_encode(&key, &wave));
+    CHECK_EQ(wave.count, SUBGHZ_WAVE_MAX);
+    CHECK_EQ(wave.timings[2], -SUBGHZ_CAME_TE_LONG);
+    CHECK_EQ(wave.timings[4], -SUBGHZ_CAME_TE_SHORT);
+}
+
+static void test_rejected(void) {
+    SubghzWave wave;
+    SubghzKey key = {.proto = SubghzProtoPrinceton, .bits = 0, .key = 1};
+    CHECK(!subghz_codec_encode(&key, &wave));
+    CHECK_EQ(wave.count, 0);
+    key.bits = SUBGHZ_CODE_MAX_BITS + 1;
+    CHECK(!subghz_codec_encode(&key, &wave));
+    key = (SubghzKey){.proto = SubghzProtoCount, .bits = 12, .key = 1};
+    CHECK(!subghz_codec_encode(&key, &wave));
+}
+
+static void test_proto_names(void) {
+    uint8_t proto = SubghzProtoCount;
+    CHECK(subghz_codec_proto_from_name("princeton", &proto));
+    CHECK_EQ(proto, SubghzProtoPrinceton);
+    CHECK(subghz_codec_proto_from_name("Came", &proto));
+    CHECK_EQ(proto, SubghzProtoCame);
+    CHECK(!subghz_codec_proto_from_name("nice", &proto));
+    CHECK_EQ(proto, SubghzProtoCame);
+    CHECK(subghz_codec_proto_name(SubghzProtoCount)[0] == '?');
+}
+
+int main(void) {
+    TEST_RUN(test_princeton);
+    TEST_RUN(test_came);
+    TEST_RUN(test_frame_length);
+    TEST_RUN(test_rejected);
+    TEST_RUN(test_proto_names);
+    TEST_EXIT();
+}
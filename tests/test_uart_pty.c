@@ -0,0 +1,187 @@
+#define _GNU_SOURCE
+#include "test.h"
+#include "src/command.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// Throughput of the UART bridge line protocol over a Linux pty standing in for the USART.
+// The bridge side reads 32 byte chunks like uart_bridge_worker(), frames them with
+// cmd_line_feed(), parses with cmd_parse() and answers every line. The host side streams the
+// commands and counts the replies.
+
+#define PTY_LINES      20000
+#define PTY_CHUNK_SIZE 32
+#define PTY_BAUD       115200
+
+static const char* const profile_names[] = {"Near", "Room", "Floor", "Far"};
+
+static const char* const commands[] = {
+    "PRESS 1 SHORT\n",
+    "SEND 0 long_double\r\n",
+    "SENSOR temp=21.5 batt=80 volt=3.05\n",
+    "PROFILE far\n",
+    "PRESS 9\n", // Rejected, no such button
+};
+
+typedef struct {
+    int fd;
+    uint32_t lines;
+    uint32_t errors;
+} PtyBridge;
+
+static void pty_write_all(int fd, const char* data, size_t len) {
+    while(len > 0) {
+        const ssize_t written = write(fd, data, len);
+        if(written <= 0) {
+            return;
+        }
+        data += written;
+        len -= written;
+    }
+}
+
+static void* pty_bridge_thread(void* context) {
+    PtyBridge* bridge = context;
+    const CmdParser parser = {
+        .profile_names = profile_names,
+        .profile_count = COUNT_OF(profile_names),
+        .button_count = 5,
+    };
+    CmdLine line = {0};
+    char chunk[PTY_CHUNK_SIZE];
+    char reply[CMD_LINE_SIZE];
+    ssize_t len;
+    while(bridge->lines < PTY_LINES && (len = read(bridge->fd, chunk, sizeof(chunk))) > 0) {
+        for(ssize_t i = 0; i < len; i++) {
+            const CmdLineStatus status = cmd_line_feed(&line, chunk[i]);
+            if(status == CmdLineNone) {
+                continue;
+            }
+            const char* error = "line too long";
+            Cmd cmd;
+            bridge->lines++;
+            if(status == CmdLineReady && cmd_parse(&parser, line.buf, &cmd, &error)) {
+                pty_write_all(bridge->fd, "OK\r\n", 4);
+            } else {
+                bridge->errors++;
+                const int size = snprintf(reply, sizeof(reply), "ERR %s\r\n", error);
+                pty_write_all(bridge->fd, reply, size);
+            }
+        }
+    }
+    return NULL;
+}
+
+static void* pty_host_writer(void* context) {
+    const int fd = *(int*)context;
+    for(uint32_t i = 0; i < PTY_LINES; i++) {
+        const char* command = commands[i % COUNT_OF(commands)];
+        pty_write_all(fd, command, strlen(command));
+    }
+    return NULL;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void test_pty_throughput(void) {
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    CHECK(master >= 0);
+    if(master < 0) {
+        return;
+    }
+    CHECK(grantpt(master) == 0 && unlockpt(master) == 0);
+    PtyBridge bridge = {.fd = open(ptsname(master), O_RDWR | O_NOCTTY)};
+    CHECK(bridge.fd >= 0);
+    if(bridge.fd < 0) {
+        close(master);
+        return;
+    }
+    // Raw bytes both ways, no echo and no \r\n translation, like the USART
+    struct termios tio;
+    tcgetattr(bridge.fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(bridge.fd, TCSANOW, &tio);
+
+    pthread_t bridge_thread, writer_thread;
+    const double start = now_s();
+    pthread_create(&bridge_thread, NULL, pty_bridge_thread, &bridge);
+    pthread_create(&writer_thread, NULL, pty_host_writer, (void*)&master);
+
+    // Count the replies on the host side
+    uint32_t ok = 0, err = 0;
+    char buf[256];
+    char last = '\n';
+    ssize_t len;
+    while(ok + err < PTY_LINES && (len = read(master, buf, sizeof(buf))) > 0) {
+        for(ssize_t i = 0; i < len; i++) {
+            if(last == '\n') {
+                ok += buf[i] == 'O';
+                err += buf[i] == 'E';
+            }
+            last = buf[i];
+        }
+    }
+    const double elapsed = now_s() - start;
+    pthread_join(writer_thread, NULL);
+    pthread_join(bridge_thread, NULL);
+    close(bridge.fd);
+    close(master);
+
+    CHECK_EQ(bridge.lines, PTY_LINES);
+    CHECK_EQ(ok + err, PTY_LINES);
+    CHECK_EQ(err, PTY_LINES / COUNT_OF(commands));
+    CHECK_EQ(bridge.errors, err);
+
+    // 10 bits per byte on the wire at 8N1
+    size_t bytes = 0;
+    for(size_t i = 0; i < COUNT_OF(commands); i++) {
+        bytes += strlen(commands[i]);
+    }
+    const double wire_rate = PTY_BAUD / 10.0 / ((double)bytes / COUNT_OF(commands));
+    const double rate = PTY_LINES / elapsed;
+    printf(
+        "  %u lines in %.3f s, %.0f lines/s, %.0f lines/s at %u baud\n",
+        PTY_LINES,
+        elapsed,
+        rate,
+        wire_rate,
+        PTY_BAUD);
+    // The framing and parsing must keep up with the USART
+    CHECK(rate > wire_rate);
+}
+
+static void test_line_framing(void) {
+    CmdLine line = {0};
+    const char* input = "\r\nPRESS 1\r\n\n";
+    uint8_t ready = 0;
+    for(const char* c = input; *c; c++) {
+        if(cmd_line_feed(&line, *c) == CmdLineReady) {
+            ready++;
+            CHECK(strcmp(line.buf, "PRESS 1") == 0);
+        }
+    }
+    CHECK_EQ(ready, 1);
+
+    // A line longer than the buffer is reported once at its end, the next one is fine
+    for(int i = 0; i < CMD_LINE_SIZE + 10; i++) {
+        CHECK_EQ(cmd_line_feed(&line, 'A'), CmdLineNone);
+    }
+    CHECK_EQ(cmd_line_feed(&line, '\n'), CmdLineTooLong);
+    CHECK_EQ(cmd_line_feed(&line, 'B'), CmdLineNone);
+    CHECK_EQ(cmd_line_feed(&line, '\r'), CmdLineReady);
+    CHECK(strcmp(line.buf, "B") == 0);
+}
+
+int main(void) {
+    TEST_RUN(test_line_framing);
+    TEST_RUN(test_pty_throughput);
+    TEST_EXIT();
+}